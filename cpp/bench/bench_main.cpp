@@ -0,0 +1,340 @@
+// kv_sim_bench: micro-benchmarks of the simulator's hot paths and macro-benchmarks of
+// whole synthetic runs. Built on Google Benchmark, so results can be tracked over time with
+//   ./kv_sim_bench --benchmark_format=json --benchmark_out=bench.json
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <new>
+#include <random>
+#include <string>
+#include "simulator.hpp"
+#include "io_trace.hpp"
+
+// Heap accounting for BM_Macro's bytes_per_request. Every allocation carries its size in a
+// header so deletes can be subtracted; the counters only move while counting is on, so
+// the micro-benchmarks pay for nothing but the header.
+namespace heap {
+
+std::atomic<bool> counting{false};
+std::atomic<std::size_t> live{0};
+std::atomic<std::size_t> peak{0};
+
+void note_alloc(std::size_t n) {
+    if (!counting.load(std::memory_order_relaxed)) return;
+    std::size_t now = live.fetch_add(n, std::memory_order_relaxed) + n;
+    std::size_t prev = peak.load(std::memory_order_relaxed);
+    while (now > prev && !peak.compare_exchange_weak(prev, now, std::memory_order_relaxed)) {
+    }
+}
+
+void note_free(std::size_t n) {
+    if (counting.load(std::memory_order_relaxed)) live.fetch_sub(n, std::memory_order_relaxed);
+}
+
+// Header of `align` bytes in front of the block; its last word holds the size, or 0 for a
+// block allocated while counting was off
+void* allocate(std::size_t n, std::size_t align) {
+    align = std::max(align, alignof(std::max_align_t));
+    std::size_t total = (n + align + align - 1) / align * align;
+    void* base = std::aligned_alloc(align, total);
+    if (!base) throw std::bad_alloc();
+    char* p = static_cast<char*>(base) + align;
+    bool counted = counting.load(std::memory_order_relaxed);
+    reinterpret_cast<std::size_t*>(p)[-1] = counted ? n : 0;
+    if (counted) note_alloc(n);
+    return p;
+}
+
+void release(void* p, std::size_t align) {
+    if (!p) return;
+    align = std::max(align, alignof(std::max_align_t));
+    std::size_t n = static_cast<std::size_t*>(p)[-1];
+    if (n) note_free(n);
+    std::free(static_cast<char*>(p) - align);
+}
+
+}  // namespace heap
+
+void* operator new(std::size_t n) { return heap::allocate(n, 0); }
+void* operator new(std::size_t n, std::align_val_t a) { return heap::allocate(n, static_cast<std::size_t>(a)); }
+void operator delete(void* p) noexcept { heap::release(p, 0); }
+void operator delete(void* p, std::size_t) noexcept { heap::release(p, 0); }
+void operator delete(void* p, std::align_val_t a) noexcept { heap::release(p, static_cast<std::size_t>(a)); }
+void operator delete(void* p, std::size_t, std::align_val_t a) noexcept {
+    heap::release(p, static_cast<std::size_t>(a));
+}
+
+// Reaches the private members the micro-benchmarks drive directly
+struct SimulatorBenchAccess {
+    static void touch_lru(Simulator& s, int req_idx, int gpu_idx) { s.touch_lru(req_idx, gpu_idx); }
+    static bool evict_one(Simulator& s, int gpu_idx) { return s.evict_one(gpu_idx); }
+    static int route_arrival(Simulator& s, int req_idx) { return s.route_gpu_for_request(req_idx); }
+    static int route_decode(Simulator& s, int prefill_gpu, int req_idx) {
+        return s.route_decode(prefill_gpu, s.requests_[req_idx]);
+    }
+
+    // Puts every request in decode on gpu_idx, holding its full KV, most recent last
+    static void fill_decoding(Simulator& s, int gpu_idx) {
+        std::uint64_t per_token = s.cfg_.policy.kv_bytes_per_token;
+        for (int r = 0; r < static_cast<int>(s.requests_.size()); ++r) {
+            auto& req = s.requests_[r];
+            req.state = RequestState::Decode;
+            s.allocate_kv_bytes(r, static_cast<std::uint64_t>(req.prompt_tokens + req.gen_tokens) * per_token, gpu_idx);
+            s.gpus_[gpu_idx].active_decode++;
+            s.touch_lru(r, gpu_idx);
+            s.gpus_[gpu_idx].evict_queue.push_back(r);
+        }
+    }
+
+    // Random but plausible load so routing scores differ across GPUs
+    static void spread_load(Simulator& s, std::mt19937& gen) {
+        std::uniform_int_distribution<int> active(0, 8);
+        for (auto& g : s.gpus_) {
+            g.active_prefill = active(gen);
+            g.active_decode = active(gen);
+            g.vram_used = static_cast<std::uint64_t>(active(gen)) * (1ull << 30);
+        }
+    }
+};
+
+namespace {
+
+// Poisson arrivals at a per-GPU rate that keeps a mid-sized cluster busy but stable
+std::vector<Request> synthetic_requests(int n, int num_gpus, unsigned seed = 42) {
+    std::mt19937 gen(seed);
+    std::exponential_distribution<double> gap(0.02 * num_gpus);  // 20 req/s per GPU
+    std::uniform_int_distribution<int> prompt(128, 2048);
+    std::uniform_int_distribution<int> out(32, 512);
+    std::vector<Request> reqs(n);
+    double t = 0.0;
+    for (int i = 0; i < n; ++i) {
+        t += gap(gen);
+        reqs[i].id = "r" + std::to_string(i);
+        reqs[i].arrival_time_ms = t;
+        reqs[i].prompt_tokens = prompt(gen);
+        reqs[i].gen_tokens = out(gen);
+    }
+    return reqs;
+}
+
+SimConfig synthetic_config(int num_gpus) {
+    SimConfig cfg;
+    cfg.gpus.assign(num_gpus, GPUConfig{});
+    for (auto& g : cfg.gpus) {
+        g.prefill_tps = 20000.0;
+        g.decode_tps = 4000.0;
+        g.vram_bytes = 8ull * 1024ull * 1024ull * 1024ull;
+    }
+    cfg.policy.kv_bytes_per_token = 131072;
+    cfg.timeseries_dt_ms = 100.0;
+    return cfg;
+}
+
+// Upper bound on the memory a macro run needs: per-request records plus the dense
+// per-GPU per-request tables (allocation, LRU position, prefill queue slot). Measured
+// peaks are about 1.1 KB + 50 B per GPU per request.
+double macro_footprint_gb(std::int64_t requests, std::int64_t gpus) {
+    double per_request = 1536.0 + 56.0 * static_cast<double>(gpus);
+    return per_request * static_cast<double>(requests) / (1024.0 * 1024.0 * 1024.0);
+}
+
+double mem_budget_gb() {
+    const char* env = std::getenv("KV_SIM_BENCH_MEM_GB");
+    return env ? std::atof(env) : 4.0;
+}
+
+}  // namespace
+
+// ---------------------------------------------------------------- micro
+
+static void BM_EventQueuePushPop(benchmark::State& state) {
+    const int n = static_cast<int>(state.range(0));
+    std::mt19937 gen(1);
+    std::uniform_real_distribution<double> when(0.0, 1e6);
+    std::vector<Event> events(n);
+    for (int i = 0; i < n; ++i) events[i] = Event{when(gen), EventType::Finish, i, i % 8};
+    for (auto _ : state) {
+        EventQueue pq;
+        for (const auto& e : events) pq.push(e);
+        while (!pq.empty()) pq.pop();
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * n);
+}
+BENCHMARK(BM_EventQueuePushPop)->RangeMultiplier(10)->Range(1000, 1000000);
+
+static void BM_TouchLru(benchmark::State& state) {
+    const int n = static_cast<int>(state.range(0));
+    SimConfig cfg = synthetic_config(1);
+    cfg.policy.eviction_policy = EvictionPolicy::LRU;
+    Simulator sim(cfg, synthetic_requests(n, 1));
+    for (int r = 0; r < n; ++r) SimulatorBenchAccess::touch_lru(sim, r, 0);
+    std::mt19937 gen(2);
+    std::uniform_int_distribution<int> pick(0, n - 1);
+    for (auto _ : state) {
+        SimulatorBenchAccess::touch_lru(sim, pick(gen), 0);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_TouchLru)->RangeMultiplier(10)->Range(1000, 1000000);
+
+static void BM_EvictOne(benchmark::State& state) {
+    const int n = static_cast<int>(state.range(0));
+    SimConfig cfg = synthetic_config(1);
+    cfg.gpus[0].vram_bytes = ~0ull;
+    cfg.policy.memory_pressure_policy = MemoryPressurePolicy::Evict;
+    cfg.policy.eviction_policy = state.range(1) ? EvictionPolicy::LRU : EvictionPolicy::FIFO;
+    std::vector<Request> reqs = synthetic_requests(n, 1);
+    for (auto _ : state) {
+        state.PauseTiming();
+        Simulator sim(cfg, reqs);
+        SimulatorBenchAccess::fill_decoding(sim, 0);
+        state.ResumeTiming();
+        while (SimulatorBenchAccess::evict_one(sim, 0)) {
+        }
+        state.PauseTiming();
+        benchmark::DoNotOptimize(sim.events().size());
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * n);
+}
+BENCHMARK(BM_EvictOne)->ArgsProduct({{1000, 100000}, {0, 1}})->ArgNames({"requests", "lru"});
+
+static void BM_RouteArrival(benchmark::State& state) {
+    const int gpus = static_cast<int>(state.range(0));
+    Simulator sim(synthetic_config(gpus), synthetic_requests(1024, gpus));
+    std::mt19937 gen(3);
+    SimulatorBenchAccess::spread_load(sim, gen);
+    int r = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(SimulatorBenchAccess::route_arrival(sim, r));
+        r = (r + 1) & 1023;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_RouteArrival)->RangeMultiplier(4)->Range(2, 256);
+
+static void BM_RouteDecode(benchmark::State& state) {
+    const int gpus = static_cast<int>(state.range(0));
+    Simulator sim(synthetic_config(gpus), synthetic_requests(1024, gpus));
+    std::mt19937 gen(4);
+    SimulatorBenchAccess::spread_load(sim, gen);
+    int r = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(SimulatorBenchAccess::route_decode(sim, r % gpus, r));
+        r = (r + 1) & 1023;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_RouteDecode)->RangeMultiplier(4)->Range(2, 256);
+
+static void BM_TraceParse(benchmark::State& state) {
+    const int n = static_cast<int>(state.range(0));
+    std::string path = "kv_sim_bench_trace_" + std::to_string(n) + ".txt";
+    {
+        std::ofstream ofs(path);
+        for (const auto& r : synthetic_requests(n, 8)) {
+            ofs << r.id << ' ' << r.arrival_time_ms << ' ' << r.prompt_tokens << ' ' << r.gen_tokens << " 0\n";
+        }
+    }
+    std::ifstream probe(path, std::ios::ate | std::ios::binary);
+    auto file_bytes = static_cast<std::int64_t>(probe.tellg());
+    std::string err;
+    for (auto _ : state) {
+        std::vector<Request> reqs;
+        if (!load_trace(path, reqs, err)) {
+            state.SkipWithError(err.c_str());
+            break;
+        }
+        benchmark::DoNotOptimize(reqs.data());
+    }
+    std::remove(path.c_str());
+    state.SetItemsProcessed(state.iterations() * n);
+    state.SetBytesProcessed(state.iterations() * file_bytes);
+}
+BENCHMARK(BM_TraceParse)->RangeMultiplier(10)->Range(1000, 1000000)->Unit(benchmark::kMillisecond);
+
+// Back-to-back short runs, as in a parameter sweep: a fresh Simulator per run versus
+// one Simulator reset between runs
+static void BM_Sweep(benchmark::State& state) {
+    const int n = static_cast<int>(state.range(0));
+    const bool reuse = state.range(1) != 0;
+    SimConfig cfg = synthetic_config(4);
+    std::vector<Request> reqs = synthetic_requests(n, 4);
+    Simulator reused(cfg, reqs);
+    reused.set_verbose(false);
+    unsigned seed = 0;
+    for (auto _ : state) {
+        cfg.seed = ++seed;
+        if (reuse) {
+            reused.reset(cfg, reqs);
+            reused.run();
+            benchmark::DoNotOptimize(reused.events().size());
+        } else {
+            Simulator sim(cfg, reqs);
+            sim.set_verbose(false);
+            sim.run();
+            benchmark::DoNotOptimize(sim.events().size());
+        }
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Sweep)->ArgsProduct({{100, 1000, 10000}, {0, 1}})->ArgNames({"requests", "reuse"});
+
+// ---------------------------------------------------------------- macro
+
+// Whole run of a synthetic workload; reports processed events/sec (profiling builds) and the
+// peak heap bytes/request of the Simulator. Grid points over KV_SIM_BENCH_MEM_GB (default 4)
+// are skipped rather than swapping.
+static void BM_Macro(benchmark::State& state) {
+    const std::int64_t requests = state.range(0);
+    const int gpus = static_cast<int>(state.range(1));
+    double need_gb = macro_footprint_gb(requests, gpus);
+    if (need_gb > mem_budget_gb()) {
+        std::string msg = "needs ~" + std::to_string(need_gb) + " GB; raise KV_SIM_BENCH_MEM_GB";
+        state.SkipWithError(msg.c_str());
+        for (auto _ : state) {
+        }
+        return;
+    }
+    SimConfig cfg = synthetic_config(gpus);
+    std::vector<Request> reqs = synthetic_requests(static_cast<int>(requests), gpus);
+    std::uint64_t events = 0;
+    double bytes_per_request = 0.0;
+    for (auto _ : state) {
+        state.PauseTiming();
+        std::size_t base = heap::live.load();
+        heap::peak.store(base);
+        heap::counting.store(true);
+        auto sim = std::make_unique<Simulator>(cfg, reqs);
+        sim->set_verbose(false);
+        state.ResumeTiming();
+        sim->run();
+        state.PauseTiming();
+        events = sim->perf_stats().events_processed;
+        bytes_per_request = static_cast<double>(heap::peak.load() - base) / static_cast<double>(requests);
+        sim.reset();
+        heap::counting.store(false);
+        state.ResumeTiming();
+    }
+#ifndef KV_SIM_PROFILE
+    state.SetLabel("events need a KV_SIM_PROFILE build");
+#endif
+    state.counters["events"] = static_cast<double>(events);
+    state.counters["events_per_sec"] = benchmark::Counter(static_cast<double>(events) * state.iterations(),
+                                                          benchmark::Counter::kIsRate);
+    state.counters["bytes_per_request"] = bytes_per_request;
+}
+BENCHMARK(BM_Macro)
+    ->ArgsProduct({{1000, 100000, 1000000}, {1, 4, 16, 64, 256}})
+    ->ArgNames({"requests", "gpus"})
+    ->Iterations(1)
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,294 @@
+// kv_sim_native: in-process Python bindings over kv_sim_core.
+//
+//   import kv_sim_native as kv
+//   res = kv.run(config_text, arrival_ms=a, prompt_tokens=p, gen_tokens=g, seed=7)
+//   res.summary                  # dict, parsed from the same text as summary.json
+//   res.timeseries["vram_used"]  # read-only NumPy view into the simulator's samples
+//
+// Column arrays are strided views into the result's own storage (no copy); they keep the
+// result alive. The GIL is released while the simulation runs.
+//
+// kv_sim_native.Session steps a run incrementally (run_for / step_until) so callers can
+// stream timeseries rows while it progresses, and cancel() it from another thread. cancel()
+// is the only call that may overlap a step in progress.
+#include <pybind11/numpy.h>
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+#include <cstddef>
+#include <memory>
+#include <sstream>
+#include "io_config.hpp"
+#include "io_output.hpp"
+#include "io_trace.hpp"
+#include "kv_sim.hpp"
+#include "result_cache.hpp"
+#include "simulator.hpp"
+#include "trace_export.hpp"
+
+namespace py = pybind11;
+
+static_assert(sizeof(EventType) == sizeof(std::int32_t), "event type view assumes a 32-bit enum");
+
+namespace {
+
+// A finished run; views handed out by it stay valid because the session no longer changes
+struct PyResult {
+    std::shared_ptr<SimSession> session;
+};
+
+// A run in progress, stepped from Python
+struct PySession {
+    std::shared_ptr<SimSession> session;
+};
+
+SimConfig parse_config(const std::string& config_text, py::object seed) {
+    SimConfig cfg;
+    std::istringstream is(config_text);
+    std::string err;
+    if (!load_config_stream(is, cfg, err)) throw std::runtime_error("config: " + err);
+    if (!seed.is_none()) cfg.seed = seed.cast<unsigned int>();  // like --seed, overrides the config
+    return cfg;
+}
+
+std::unique_ptr<PyResult> run_session(SimConfig cfg, std::vector<Request> reqs, int threads) {
+    auto res = std::make_unique<PyResult>();
+    res->session = std::make_shared<SimSession>(std::move(cfg), std::move(reqs));
+    {
+        py::gil_scoped_release release;
+        res->session->run(threads);
+    }
+    return res;
+}
+
+std::vector<Request> parse_trace(py::object trace_text, py::object trace_path) {
+    std::vector<Request> reqs;
+    std::string err;
+    bool ok = false;
+    if (!trace_text.is_none()) {
+        std::istringstream is(trace_text.cast<std::string>());
+        ok = load_trace_stream(is, reqs, err);
+    } else if (!trace_path.is_none()) {
+        ok = load_trace(trace_path.cast<std::string>(), reqs, err);
+    } else {
+        err = "provide trace_text or trace_path";
+    }
+    if (!ok) throw std::runtime_error("trace: " + err);
+    return reqs;
+}
+
+// Timeseries samples [start, end) as dicts keyed like the timeseries.csv columns
+py::list timeseries_rows(const Simulator& sim, std::size_t start) {
+    const auto& s = sim.samples();
+    py::list rows;
+    for (std::size_t i = start; i < s.size(); ++i) {
+        py::dict row;
+        row["time_ms"] = s[i].time_ms;
+        row["vram_used"] = s[i].vram_used;
+        row["active_prefill"] = s[i].active_prefill;
+        row["active_decode"] = s[i].active_decode;
+        row["queue_depth"] = s[i].queue_depth;
+        row["tokens_generated_delta"] = s[i].tokens_generated_delta;
+        row["rejects_delta"] = s[i].rejects_delta;
+        for (int g = 0; g < sim.num_gpus(); ++g) {
+            row[py::str("vram_gpu" + std::to_string(g))] =
+                g < static_cast<int>(s[i].vram_per_gpu.size()) ? s[i].vram_per_gpu[g] : 0;
+        }
+        row["global_queue_depth"] = s[i].global_queue_depth;
+        rows.append(row);
+    }
+    return rows;
+}
+
+// Read-only strided view of one member across a vector of structs, owned by `owner`
+template <class T, class Struct>
+py::array member_view(const std::vector<Struct>& v, const T* first, py::handle owner) {
+    std::vector<py::ssize_t> shape = {static_cast<py::ssize_t>(v.size())};
+    std::vector<py::ssize_t> strides = {static_cast<py::ssize_t>(sizeof(Struct))};
+    static const T empty{};
+    py::array a(py::dtype::of<T>(), shape, strides, v.empty() ? &empty : first, owner);
+    a.attr("setflags")(py::arg("write") = false);
+    return a;
+}
+
+// Parsed from the summary.json text itself, so the keys never drift from the file
+py::object summary_dict(const SimSession& session) {
+    return py::module_::import("json").attr("loads")(session.summary_json());
+}
+
+}  // namespace
+
+PYBIND11_MODULE(kv_sim_native, m) {
+    m.doc() = "In-process bindings for the kv_sim simulator core";
+
+    py::class_<PyResult>(m, "Result")
+        .def_property_readonly("summary", [](const PyResult& r) { return summary_dict(*r.session); })
+        .def_property_readonly("timeseries", [](py::object self) {
+            const auto& r = self.cast<const PyResult&>();
+            const auto& s = r.session->simulator().samples();
+            const TimeseriesSample* f = s.empty() ? nullptr : &s[0];
+            py::dict d;
+            d["time_ms"] = member_view<double>(s, f ? &f->time_ms : nullptr, self);
+            d["vram_used"] = member_view<std::uint64_t>(s, f ? &f->vram_used : nullptr, self);
+            d["active_prefill"] = member_view<int>(s, f ? &f->active_prefill : nullptr, self);
+            d["active_decode"] = member_view<int>(s, f ? &f->active_decode : nullptr, self);
+            d["queue_depth"] = member_view<int>(s, f ? &f->queue_depth : nullptr, self);
+            d["tokens_generated_delta"] = member_view<std::uint64_t>(s, f ? &f->tokens_generated_delta : nullptr, self);
+            d["rejects_delta"] = member_view<int>(s, f ? &f->rejects_delta : nullptr, self);
+            d["global_queue_depth"] = member_view<int>(s, f ? &f->global_queue_depth : nullptr, self);
+            return d;
+        })
+        .def("vram_per_gpu", [](const PyResult& r) {
+            // Per-sample vectors are not contiguous, so this one is a copy
+            const auto& s = r.session->simulator().samples();
+            auto gpus = static_cast<py::ssize_t>(r.session->simulator().num_gpus());
+            py::array_t<std::uint64_t> out({static_cast<py::ssize_t>(s.size()), gpus});
+            auto w = out.mutable_unchecked<2>();
+            for (py::ssize_t i = 0; i < static_cast<py::ssize_t>(s.size()); ++i) {
+                for (py::ssize_t g = 0; g < gpus; ++g) {
+                    w(i, g) = g < static_cast<py::ssize_t>(s[i].vram_per_gpu.size()) ? s[i].vram_per_gpu[g] : 0;
+                }
+            }
+            return out;
+        })
+        .def_property_readonly("events", [](py::object self) {
+            const auto& r = self.cast<const PyResult&>();
+            const auto& e = r.session->simulator().events();
+            const EventRecord* f = e.empty() ? nullptr : &e[0];
+            py::dict d;
+            d["time_ms"] = member_view<double>(e, f ? &f->time_ms : nullptr, self);
+            d["type"] = member_view<std::int32_t>(e, f ? reinterpret_cast<const std::int32_t*>(&f->type) : nullptr, self);
+            d["gpu_index"] = member_view<int>(e, f ? &f->gpu_index : nullptr, self);
+            return d;
+        })
+        .def("event_request_ids", [](const PyResult& r) {
+            py::list ids;
+            for (const auto& e : r.session->simulator().events()) ids.append(e.request_id);
+            return ids;
+        })
+        .def("timeseries_csv", [](const PyResult& r) {
+            std::ostringstream os;
+            format_timeseries_csv(os, r.session->simulator().samples(), r.session->simulator().num_gpus());
+            return os.str();
+        })
+        .def("events_jsonl", [](const PyResult& r) {
+            std::ostringstream os;
+            format_events_jsonl(os, r.session->simulator().events());
+            return os.str();
+        })
+        .def("write_chrome_trace", [](const PyResult& r, const std::string& path) {
+            const auto& sim = r.session->simulator();
+            // The log is only the recorder's window; the timeline would silently start late
+            if (sim.flight_recorder().enabled()) {
+                throw std::runtime_error("write_chrome_trace needs the full event log; the run used flight_recorder");
+            }
+            std::string err;
+            if (!write_chrome_trace(path, sim.events(), sim.samples(), sim.num_gpus(), err)) throw std::runtime_error(err);
+        }, "Chrome trace-event JSON of the run, for ui.perfetto.dev")
+        .def("write_outputs", [](const PyResult& r, const std::string& out_dir) {
+            std::string err;
+            if (!r.session->write_outputs(out_dir, err)) throw std::runtime_error(err);
+        });
+
+    py::class_<PySession>(m, "Session")
+        .def(py::init([](const std::string& config_text, py::object trace_text, py::object trace_path, py::object seed) {
+                 auto cfg = parse_config(config_text, seed);
+                 auto reqs = parse_trace(trace_text, trace_path);
+                 return PySession{std::make_shared<SimSession>(std::move(cfg), std::move(reqs))};
+             }),
+             py::arg("config_text") = "", py::arg("trace_text") = py::none(), py::arg("trace_path") = py::none(),
+             py::arg("seed") = py::none())
+        .def("run_for", [](PySession& s, std::size_t n_events) {
+            py::gil_scoped_release release;
+            return s.session->run_for(n_events);
+        }, py::arg("n_events"), "Process at most n_events events; False once the run is complete")
+        .def("step_until", [](PySession& s, double t_ms) {
+            py::gil_scoped_release release;
+            return s.session->step_until(t_ms);
+        }, py::arg("t_ms"), "Process events up to t_ms; False once the run is complete")
+        .def("cancel", [](PySession& s) { s.session->cancel(); }, "Stop at the next event; safe from another thread")
+        .def_property_readonly("done", [](const PySession& s) { return s.session->done(); })
+        .def_property_readonly("cancelled", [](const PySession& s) { return s.session->cancelled(); })
+        .def_property_readonly("now_ms", [](const PySession& s) { return s.session->now_ms(); })
+        .def_property_readonly("num_samples", [](const PySession& s) { return s.session->simulator().samples().size(); })
+        .def("timeseries_rows", [](const PySession& s, std::size_t start) {
+            return timeseries_rows(s.session->simulator(), start);
+        }, py::arg("start") = 0, "Samples from index start on, as dicts keyed like timeseries.csv")
+        .def("summary", [](const PySession& s) { return summary_dict(*s.session); })
+        .def("write_outputs", [](const PySession& s, const std::string& out_dir) {
+            std::string err;
+            if (!s.session->write_outputs(out_dir, err)) throw std::runtime_error(err);
+        })
+        .def("result", [](const PySession& s) {
+            if (!s.session->done()) throw std::runtime_error("session is still running");
+            return std::make_unique<PyResult>(PyResult{s.session});
+        });
+
+    m.def(
+        "cache_key",
+        [](const std::string& config_text, py::object trace_text, py::object trace_path, py::object seed) {
+            return cache_key(parse_config(config_text, seed), parse_trace(trace_text, trace_path));
+        },
+        py::arg("config_text") = "", py::arg("trace_text") = py::none(), py::arg("trace_path") = py::none(),
+        py::arg("seed") = py::none(),
+        "Result-cache key of a run: build, trace, effective config and seed");
+    m.def(
+        "cache_fetch",
+        [](const std::string& cache_dir, const std::string& key, const std::string& out_dir) {
+            return ResultCache(cache_dir).fetch(key, out_dir);
+        },
+        py::arg("cache_dir"), py::arg("key"), py::arg("out_dir"), "Copy a cached run into out_dir; False on a miss");
+    m.def(
+        "cache_store",
+        [](const std::string& cache_dir, const std::string& key, const std::string& out_dir) {
+            std::string err;
+            if (!ResultCache(cache_dir).store(key, out_dir, err)) throw std::runtime_error(err);
+        },
+        py::arg("cache_dir"), py::arg("key"), py::arg("out_dir"), "Save out_dir's outputs under key");
+
+    py::list names;
+    for (int t = 0; t < kNumEventTypes; ++t) names.append(event_type_str(static_cast<EventType>(t)));
+    m.attr("EVENT_TYPES") = names;
+
+    m.def(
+        "run",
+        [](const std::string& config_text,
+           py::array_t<double, py::array::c_style | py::array::forcecast> arrival_ms,
+           py::array_t<std::int32_t, py::array::c_style | py::array::forcecast> prompt_tokens,
+           py::array_t<std::int32_t, py::array::c_style | py::array::forcecast> gen_tokens,
+           py::object streaming, py::object ids, py::object seed, int threads) {
+            py::ssize_t n = arrival_ms.size();
+            if (prompt_tokens.size() != n || gen_tokens.size() != n) {
+                throw std::invalid_argument("arrival_ms, prompt_tokens and gen_tokens must have equal length");
+            }
+            std::vector<Request> reqs(static_cast<std::size_t>(n));
+            auto a = arrival_ms.unchecked<1>();
+            auto p = prompt_tokens.unchecked<1>();
+            auto g = gen_tokens.unchecked<1>();
+            py::array_t<bool, py::array::c_style | py::array::forcecast> stream_arr;
+            if (!streaming.is_none()) stream_arr = streaming.cast<decltype(stream_arr)>();
+            std::vector<std::string> id_list;
+            if (!ids.is_none()) id_list = ids.cast<std::vector<std::string>>();
+            for (py::ssize_t i = 0; i < n; ++i) {
+                auto& r = reqs[static_cast<std::size_t>(i)];
+                r.id = i < static_cast<py::ssize_t>(id_list.size()) ? id_list[i] : "r" + std::to_string(i);
+                r.arrival_time_ms = a(i);
+                r.prompt_tokens = p(i);
+                r.gen_tokens = g(i);
+                r.streaming = stream_arr.size() > i && stream_arr.data()[i];
+            }
+            return run_session(parse_config(config_text, seed), std::move(reqs), threads);
+        },
+        py::arg("config_text") = "", py::arg("arrival_ms"), py::arg("prompt_tokens"), py::arg("gen_tokens"),
+        py::arg("streaming") = py::none(), py::arg("ids") = py::none(), py::arg("seed") = py::none(),
+        py::arg("threads") = 1,
+        "Run a simulation from NumPy request columns");
+
+    m.def(
+        "run_trace",
+        [](const std::string& config_text, py::object trace_text, py::object trace_path, py::object seed, int threads) {
+            return run_session(parse_config(config_text, seed), parse_trace(trace_text, trace_path), threads);
+        },
+        py::arg("config_text") = "", py::arg("trace_text") = py::none(), py::arg("trace_path") = py::none(),
+        py::arg("seed") = py::none(), py::arg("threads") = 1,
+        "Run a simulation from trace text or a trace file");
+}
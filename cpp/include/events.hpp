@@ -1,5 +1,8 @@
 #pragma once
+#include <algorithm>
 #include <cstdint>
+#include <queue>
+#include <vector>
 
 enum class EventType {
     Arrival,
@@ -10,7 +13,11 @@ enum class EventType {
     HandoffComplete,
     Finish,
     Reject,
-    Evict
+    Evict,
+    KvGrow,
+    SessionExpire,  // a session's retained KV reaches its TTL
+    Abandon,        // a request's client timeout expires before it finishes
+    TimerTick       // timeout wheel wake-up; carries no request (index -1)
 };
 
 struct Event {
@@ -18,10 +25,43 @@ struct Event {
     EventType type = EventType::Arrival;
     int request_index = -1;
     int gpu_index = 0;
+    std::uint32_t generation = 0;  // request's event generation at push; not part of the order
 };
 
+// Events that do nothing once their request has left the system, so they can be
+// cancelled. A stale StartPrefill still releases its prefill slot and a stale
+// HandoffStart is still logged, so those always run.
+inline bool event_cancellable(EventType type) {
+    return type == EventType::StartDecode || type == EventType::HandoffComplete ||
+           type == EventType::Finish || type == EventType::KvGrow || type == EventType::Abandon;
+}
+
+// Min-heap order on (time, request, type, gpu). Ties never depend on push order, so
+// any engine that pops in this order sees the same event sequence.
 struct EventCompare {
     bool operator()(const Event& a, const Event& b) const {
-        return a.time_ms > b.time_ms;
+        if (a.time_ms != b.time_ms) return a.time_ms > b.time_ms;
+        if (a.request_index != b.request_index) return a.request_index > b.request_index;
+        if (a.type != b.type) return a.type > b.type;
+        return a.gpu_index > b.gpu_index;
     }
 };
+
+// Event min-heap whose storage can be read and replaced for checkpoint/restore
+class EventQueue : public std::priority_queue<Event, std::vector<Event>, EventCompare> {
+public:
+    const std::vector<Event>& heap() const { return c; }
+    void assign_heap(std::vector<Event> heap) { c = std::move(heap); }
+    // Empties the queue but keeps its storage for the next run
+    void clear() { c.clear(); }
+
+    // Drops every event matching dead and rebuilds the heap; returns how many went.
+    // Pop order of the survivors is unchanged since the order is total.
+    template <typename Pred>
+    std::size_t compact(Pred dead) {
+        std::size_t before = c.size();
+        c.erase(std::remove_if(c.begin(), c.end(), dead), c.end());
+        std::make_heap(c.begin(), c.end(), comp);
+        return before - c.size();
+    }
+};
\ No newline at end of file
@@ -0,0 +1,61 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "types.hpp"
+
+// Bounded replacement for the full event log: the newest cfg.events records sit in a
+// ring, and when a timeseries sample trips a trigger the ring's window is dumped as
+// events.jsonl-style lines. Dumps never overlap (the ring must turn over between two)
+// and stop after cfg.max_dumps.
+class FlightRecorder {
+public:
+    struct Dump {
+        double time_ms = 0.0;
+        std::string reason;               // trigger and the value that tripped it
+        std::size_t num_events = 0;
+        bool written = false;             // already on disk; events is then empty
+        std::vector<EventRecord> events;  // held window, oldest first
+    };
+
+    void reset(const FlightRecorderConfig& cfg);
+    bool enabled() const { return cfg_.events > 0; }
+    // Dumps are written to <dir>/flight_<k>.jsonl as they happen; with no dir (or on a
+    // failed write) they are held in memory until write_held_dumps
+    void set_dump_dir(std::string dir) { dir_ = std::move(dir); }
+
+    void record(EventRecord r);
+    // A request's first token, for the p99 TTFT trigger
+    void note_ttft(double ttft_ms);
+    void check(const TimeseriesSample& s);
+
+    // Ring contents, oldest first
+    const std::vector<EventRecord>& window() const;
+    const std::vector<Dump>& dumps() const { return dumps_; }
+    std::uint64_t recorded() const { return recorded_; }
+    bool write_held_dumps(const std::string& dir, std::string& err) const;
+    static std::string dump_file_name(std::size_t k);
+
+private:
+    friend class Simulator;  // checkpoint save/restore
+
+    bool write_dump(const std::string& dir, std::size_t k, const std::vector<EventRecord>& events,
+                    std::string& err) const;
+    double ttft_p99();
+
+    FlightRecorderConfig cfg_;
+    std::string dir_;
+    std::vector<EventRecord> ring_;
+    std::size_t head_ = 0;  // oldest entry once the ring is full
+    std::uint64_t recorded_ = 0;
+    std::uint64_t last_dump_at_ = 0;  // recorded_ at the latest dump
+    std::vector<double> ttfts_;       // ring of the latest first-token times
+    std::size_t ttft_head_ = 0;
+    bool ttft_changed_ = false;
+    double ttft_p99_ = 0.0;
+    std::vector<double> scratch_;
+    std::vector<Dump> dumps_;
+    mutable std::vector<EventRecord> window_;
+    mutable std::uint64_t window_at_ = UINT64_MAX;  // recorded_ when window_ was built
+};
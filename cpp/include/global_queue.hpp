@@ -0,0 +1,109 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+// Requests that no GPU could take at arrival. Entries sit in size buckets (FIFO
+// within a bucket); a global sequence number orders them across buckets, so the
+// oldest waiter is always one of the bucket heads. A non-empty mask keeps scans
+// to the buckets actually in use. With a single bucket this is a plain FIFO.
+class GlobalQueue {
+public:
+    static constexpr int kNumBuckets = 64;
+
+    struct Entry {
+        int req_idx = -1;
+        std::uint64_t seq = 0;
+        double enqueued_ms = 0.0;
+    };
+
+    // Bucket b holds needs in [2^(b-1), 2^b) bytes; bucket 0 holds zero
+    static int bucket_for(std::uint64_t bytes) {
+        int b = 0;
+        while (bytes != 0 && b < kNumBuckets - 1) {
+            bytes >>= 1;
+            ++b;
+        }
+        return b;
+    }
+
+    void clear() {
+        for (auto& q : buckets_) q.clear();
+        mask_ = 0;
+        size_ = 0;
+        next_seq_ = 0;
+    }
+
+    bool empty() const { return size_ == 0; }
+    std::size_t size() const { return size_; }
+    std::uint64_t nonempty_mask() const { return mask_; }
+
+    void push(int req_idx, int bucket, double now_ms) {
+        buckets_[bucket].push_back(Entry{req_idx, next_seq_++, now_ms});
+        mask_ |= std::uint64_t{1} << bucket;
+        ++size_;
+    }
+
+    const Entry& head(int bucket) const { return buckets_[bucket].front(); }
+
+    void pop_head(int bucket) {
+        auto& q = buckets_[bucket];
+        q.pop_front();
+        if (q.empty()) mask_ &= ~(std::uint64_t{1} << bucket);
+        --size_;
+    }
+
+    // Removes a waiter from anywhere in its bucket (client timeouts). Waiters time out
+    // roughly oldest first, so the match is usually at or near a head.
+    bool erase(int req_idx) {
+        for (std::uint64_t mask = mask_; mask != 0; mask &= mask - 1) {
+            int b = lowest_bit(mask);
+            auto& q = buckets_[b];
+            auto it = std::find_if(q.begin(), q.end(), [&](const Entry& e) { return e.req_idx == req_idx; });
+            if (it == q.end()) continue;
+            q.erase(it);
+            if (q.empty()) mask_ &= ~(std::uint64_t{1} << b);
+            --size_;
+            return true;
+        }
+        return false;
+    }
+
+    // Bucket whose head is the oldest entry among the buckets in mask (-1 if none)
+    int oldest_bucket(std::uint64_t mask) const {
+        int best = -1;
+        mask &= mask_;
+        while (mask != 0) {
+            int b = lowest_bit(mask);
+            mask &= mask - 1;
+            if (best < 0 || buckets_[b].front().seq < buckets_[best].front().seq) best = b;
+        }
+        return best;
+    }
+
+    // Every entry, oldest first (for checkpoints)
+    std::vector<Entry> entries() const {
+        std::vector<Entry> out;
+        out.reserve(size_);
+        for (const auto& q : buckets_) out.insert(out.end(), q.begin(), q.end());
+        std::sort(out.begin(), out.end(), [](const Entry& a, const Entry& b) { return a.seq < b.seq; });
+        return out;
+    }
+
+private:
+    static int lowest_bit(std::uint64_t mask) {
+        int b = 0;
+        while ((mask & 1) == 0) {
+            mask >>= 1;
+            ++b;
+        }
+        return b;
+    }
+
+    std::deque<Entry> buckets_[kNumBuckets];
+    std::uint64_t mask_ = 0;
+    std::size_t size_ = 0;
+    std::uint64_t next_seq_ = 0;
+};
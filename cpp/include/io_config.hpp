@@ -1,5 +1,8 @@
 #pragma once
+#include <istream>
 #include <string>
 #include "types.hpp"
 
-bool load_config(const std::string& path, SimConfig& cfg, std::string& err);
\ No newline at end of file
+bool load_config(const std::string& path, SimConfig& cfg, std::string& err);
+// Same `key value` format from any stream, e.g. config text passed in by an embedder
+bool load_config_stream(std::istream& is, SimConfig& cfg, std::string& err);
\ No newline at end of file
@@ -1,31 +1,130 @@
 #pragma once
+#include <ostream>
 #include <string>
 #include <vector>
 #include "types.hpp"
+#include "request_table.hpp"
+#include "replication.hpp"
+#include "profiler.hpp"
+
+// Per-tenant admission counters; request outcomes are derived from reqs
+struct TenantMetrics {
+    std::string name;
+    double ttft_slo_ms = 0.0;
+    int rate_limited = 0;
+    int quota_rejected = 0;
+    int slo_rejected = 0;
+};
+
+// Per-model placement and load counters; request outcomes are derived from reqs
+struct ModelMetrics {
+    std::string name;
+    std::uint64_t weights_bytes = 0;
+    std::uint64_t kv_bytes_per_token = 0;
+    int gpus = 0;  // GPUs the model is placed on
+    int swap_ins = 0;
+};
+
+// One window the flight recorder saved, as listed in summary.json
+struct FlightDumpMetrics {
+    std::string file;  // relative to the output directory
+    double time_ms = 0.0;
+    std::string reason;
+    std::size_t events = 0;
+};
 
 // Phase 8: Extended metrics for summary output
 struct ExtendedMetrics {
     int retry_attempts = 0;
     int retry_successes = 0;
     int handoffs_total = 0;
+    int handoffs_pipelined = 0;
+    double handoff_whole_ms = 0.0;
+    double handoff_exposed_ms = 0.0;
     int cross_gpu_decodes = 0;
     int max_global_queue_depth = 0;
+    int global_backfills = 0;
+    int kv_growth_steps = 0;
+    int kv_growth_failures = 0;
+    double spec_steps_total = 0.0;
+    std::uint64_t spec_tokens_total = 0;
+    int spec_fallbacks = 0;
+    int num_sessions = 0;  // 0 when the trace has no session column
+    int session_followups = 0;
+    int session_hits = 0;
+    std::uint64_t session_reused_tokens = 0;
+    double session_prefill_saved_ms = 0.0;
+    int session_retained = 0;
+    int session_expired = 0;
+    int session_pressure_drops = 0;
+    bool timeouts = false;  // some request had a client timeout
+    int abandoned_queued = 0;
+    int abandoned_prefill = 0;  // includes the handoff after prefill
+    int abandoned_decode = 0;
+    double abandoned_prefill_ms = 0.0;
+    double abandoned_decode_tokens = 0.0;
+    std::uint64_t flight_events_recorded = 0;  // flight recorder only
+    std::vector<FlightDumpMetrics> flight_dumps;
     std::vector<std::uint64_t> peak_vram_per_gpu;
     std::vector<std::uint64_t> tokens_per_gpu;
     std::vector<int> requests_finished_per_gpu;
+    std::vector<TenantMetrics> tenants;  // empty when the run is not multi-tenant
+    std::vector<ModelMetrics> models;    // empty when the run is not multi-model
+};
+
+// Headline run metrics, as reported at the top of summary.json
+struct SummaryMetrics {
+    int finished = 0;
+    int rejected = 0;
+    double completion_rate = 0.0;
+    double reject_rate = 0.0;
+    double throughput_tokens_per_sec = 0.0;
+    double p50_latency_ms = 0.0;
+    double p95_latency_ms = 0.0;
+    double p99_latency_ms = 0.0;
+    double p50_ttft_ms = 0.0;
+    double p95_ttft_ms = 0.0;
+    double avg_vram_bytes = 0.0;
+    double gpu_busy_ms = 0.0;
+    double makespan_ms = 0.0;
+    int evictions = 0;
 };
 
+SummaryMetrics compute_summary_metrics(
+    const RequestTable& reqs,
+    const std::vector<TimeseriesSample>& samples,
+    std::uint64_t tokens_generated_total,
+    double sim_end_ms,
+    int evictions
+);
 bool write_summary(
     const std::string& out_dir,
-    const std::vector<Request>& reqs,
+    const RequestTable& reqs,
     const std::vector<TimeseriesSample>& samples,
     std::uint64_t tokens_generated_total,
     double sim_end_ms,
-    const std::vector<EventRecord>& events,
+    int evictions,
     const SimConfig& cfg,
     const ExtendedMetrics& ext_metrics,
     std::string& err
 );
 bool write_timeseries_csv(const std::string& out_dir, const std::vector<TimeseriesSample>& samples, int num_gpus, std::string& err);
 bool write_events_jsonl(const std::string& out_dir, const std::vector<EventRecord>& events, std::string& err);
-bool write_run_meta(const std::string& out_dir, const SimConfig& cfg, std::string& err, const std::string& config_path = "");
\ No newline at end of file
+// Stream forms of the three files above, for embedders that serve them without touching disk
+void format_summary(
+    std::ostream& os,
+    const RequestTable& reqs,
+    const std::vector<TimeseriesSample>& samples,
+    std::uint64_t tokens_generated_total,
+    double sim_end_ms,
+    int evictions,
+    const SimConfig& cfg,
+    const ExtendedMetrics& ext_metrics
+);
+void format_timeseries_csv(std::ostream& os, const std::vector<TimeseriesSample>& samples, int num_gpus);
+void format_events_jsonl(std::ostream& os, const std::vector<EventRecord>& events);
+std::string event_type_str(EventType t);
+bool write_run_meta(const std::string& out_dir, const SimConfig& cfg, std::string& err, const std::string& config_path = "");
+bool write_replications_json(const std::string& out_dir, const ReplicationOptions& opts, const ReplicationResult& result, std::string& err);
+// Only meaningful in KV_SIM_PROFILE builds; counts are zero otherwise
+bool write_perf_json(const std::string& out_dir, const PerfStats& perf, std::string& err);
\ No newline at end of file
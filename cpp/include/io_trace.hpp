@@ -1,6 +1,12 @@
 #pragma once
+#include <cstddef>
+#include <istream>
 #include <string>
 #include <vector>
 #include "types.hpp"
 
-bool load_trace(const std::string& path, std::vector<Request>& out, std::string& err);
\ No newline at end of file
+bool load_trace(const std::string& path, std::vector<Request>& out, std::string& err);
+bool load_trace_stream(std::istream& is, std::vector<Request>& out, std::string& err);
+// Parses an in-memory text trace on up to `threads` threads (0 = hardware concurrency);
+// inputs under a megabyte per thread use fewer. Errors name the 1-based file line.
+bool load_trace_buffer(const char* data, std::size_t size, std::vector<Request>& out, std::string& err, int threads = 0);
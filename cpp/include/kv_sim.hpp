@@ -0,0 +1,96 @@
+#pragma once
+// Embeddable API of the kv_sim_core library. Build a SimSession from a config and a
+// request source, run it (or step it through simulated time), and read the metrics in
+// memory. Writing the usual output files is optional.
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+#include "types.hpp"
+#include "io_output.hpp"
+#include "profiler.hpp"
+
+class Simulator;
+
+// Pull-style request source so embedders can feed requests without a trace file
+class RequestSource {
+public:
+    virtual ~RequestSource() = default;
+    // Fills `out` and returns true, or returns false when exhausted
+    virtual bool next(Request& out) = 0;
+};
+
+class VectorRequestSource : public RequestSource {
+public:
+    explicit VectorRequestSource(std::vector<Request> requests) : requests_(std::move(requests)) {}
+    bool next(Request& out) override {
+        if (pos_ >= requests_.size()) return false;
+        out = std::move(requests_[pos_++]);
+        return true;
+    }
+
+private:
+    std::vector<Request> requests_;
+    std::size_t pos_ = 0;
+};
+
+// Everything summary.json reports, as structures
+struct RunResult {
+    SummaryMetrics summary;
+    ExtendedMetrics extended;
+    PerfStats perf;  // zero unless built with KV_SIM_PROFILE
+};
+
+class SimSession {
+public:
+    SimSession(SimConfig cfg, std::vector<Request> requests);
+    SimSession(SimConfig cfg, RequestSource& source);
+    ~SimSession();
+    SimSession(const SimSession&) = delete;
+    SimSession& operator=(const SimSession&) = delete;
+
+    // Starts a new run in this session, reusing the simulator's storage from earlier
+    // runs; cheaper than a fresh session for sweeps of many short runs
+    void reset(SimConfig cfg, const std::vector<Request>& requests);
+    void reset(SimConfig cfg, RequestSource& source);
+
+    // Runs to completion; threads > 1 uses the parallel engine
+    void run(int threads = 1);
+    // Processes every event with time <= t_ms; returns false once the run is complete
+    bool step_until(double t_ms);
+    // Processes at most n_events events; returns false once the run is complete
+    bool run_for(std::size_t n_events);
+    bool done() const { return done_; }
+
+    // Safe to call from another thread: the run in progress stops at the next event and
+    // the session finalizes with the metrics so far
+    void cancel() { cancel_.store(true, std::memory_order_relaxed); }
+    bool cancelled() const { return cancel_.load(std::memory_order_relaxed); }
+    double now_ms() const;
+
+    // Print the end-of-run totals line on stdout, like the CLI (off by default)
+    void set_verbose(bool verbose);
+
+    // Metrics of the run so far; final once done()
+    RunResult result() const;
+    // The summary.json text of the run so far
+    std::string summary_json() const;
+
+    // summary.json, timeseries.csv, events.jsonl and run_meta.json, as the CLI writes them
+    bool write_outputs(const std::string& out_dir, std::string& err, const std::string& config_path = "") const;
+
+    const SimConfig& config() const { return cfg_; }
+    Simulator& simulator() { return *sim_; }
+    const Simulator& simulator() const { return *sim_; }
+
+private:
+    SimConfig cfg_;
+    std::unique_ptr<Simulator> sim_;
+    std::vector<Request> staging_;  // drained source requests, kept for the next reset
+    std::atomic<bool> cancel_{false};
+    bool done_ = false;
+};
+
+// Fills the extended (Phase 8 and later) metrics from a finished simulator
+ExtendedMetrics collect_extended_metrics(const Simulator& sim, const SimConfig& cfg);
@@ -0,0 +1,7 @@
+#pragma once
+#include <vector>
+#include "request_table.hpp"
+
+// Fills RequestHot::predicted_gen_tokens according to PolicyConfig::length_predictor.
+// Uses its own RNG stream so the simulator's routing draws are unaffected.
+void predict_gen_lengths(RequestTable& reqs, const PolicyConfig& policy, unsigned int seed, int replication = -1);
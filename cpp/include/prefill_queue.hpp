@@ -0,0 +1,99 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Indexed binary min-heap of request indices for a GPU's prefill queue.
+// Entries are ordered by (key, insertion seq), so equal keys pop in FIFO order.
+// pos_ maps request index -> heap slot, giving O(log n) pop and arbitrary erase.
+class PrefillQueue {
+public:
+    void reset(std::size_t num_requests) {
+        heap_.clear();
+        pos_.assign(num_requests, -1);
+        next_seq_ = 0;
+    }
+
+    bool empty() const { return heap_.empty(); }
+    std::size_t size() const { return heap_.size(); }
+    bool contains(int req_idx) const { return pos_[req_idx] >= 0; }
+
+    int top() const { return heap_.front().req_idx; }
+    double top_key() const { return heap_.front().key; }
+
+    void push(int req_idx, double key) {
+        if (contains(req_idx)) erase(req_idx);
+        heap_.push_back(Entry{key, next_seq_++, req_idx});
+        pos_[req_idx] = static_cast<int>(heap_.size() - 1);
+        sift_up(heap_.size() - 1);
+    }
+
+    int pop() {
+        int idx = heap_.front().req_idx;
+        remove_at(0);
+        return idx;
+    }
+
+    bool erase(int req_idx) {
+        int slot = pos_[req_idx];
+        if (slot < 0) return false;
+        remove_at(static_cast<std::size_t>(slot));
+        return true;
+    }
+
+private:
+    struct Entry {
+        double key = 0.0;
+        std::uint64_t seq = 0;
+        int req_idx = -1;
+    };
+
+    static bool less(const Entry& a, const Entry& b) {
+        if (a.key != b.key) return a.key < b.key;
+        return a.seq < b.seq;
+    }
+
+    void place(std::size_t i, const Entry& e) {
+        heap_[i] = e;
+        pos_[e.req_idx] = static_cast<int>(i);
+    }
+
+    void remove_at(std::size_t i) {
+        pos_[heap_[i].req_idx] = -1;
+        Entry last = heap_.back();
+        heap_.pop_back();
+        if (i == heap_.size()) return;
+        place(i, last);
+        sift_up(i);
+        sift_down(pos_[last.req_idx]);
+    }
+
+    void sift_up(std::size_t i) {
+        Entry e = heap_[i];
+        while (i > 0) {
+            std::size_t parent = (i - 1) / 2;
+            if (!less(e, heap_[parent])) break;
+            place(i, heap_[parent]);
+            i = parent;
+        }
+        place(i, e);
+    }
+
+    void sift_down(std::size_t i) {
+        Entry e = heap_[i];
+        std::size_t n = heap_.size();
+        while (true) {
+            std::size_t child = 2 * i + 1;
+            if (child >= n) break;
+            if (child + 1 < n && less(heap_[child + 1], heap_[child])) child++;
+            if (!less(heap_[child], e)) break;
+            place(i, heap_[child]);
+            i = child;
+        }
+        place(i, e);
+    }
+
+    std::vector<Entry> heap_;
+    std::vector<int> pos_;
+    std::uint64_t next_seq_ = 0;
+};
@@ -0,0 +1,72 @@
+#pragma once
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include "events.hpp"
+
+// Self-profiling counters written to perf.json. The struct always exists so the API is
+// the same in every build; it is only filled when built with KV_SIM_PROFILE (CMake option).
+constexpr int kNumEventTypes = static_cast<int>(EventType::TimerTick) + 1;
+
+struct PerfStats {
+    std::array<std::uint64_t, kNumEventTypes> event_counts{};
+    std::array<std::uint64_t, kNumEventTypes> handler_ns{};  // includes nested routing
+    std::uint64_t events_processed = 0;
+    std::uint64_t events_cancelled = 0;       // queued events killed by their request leaving
+    std::uint64_t dead_events_skipped = 0;    // popped dead instead of handled
+    std::uint64_t dead_events_compacted = 0;  // removed by heap compaction
+    std::uint64_t heap_compactions = 0;
+    std::size_t pq_high_water = 0;
+    double pq_size_sum = 0.0;   // summed at every pop, for the mean queue size
+    std::uint64_t routing_calls = 0;
+    std::uint64_t routing_ns = 0;
+    std::uint64_t sampling_ns = 0;
+    std::uint64_t run_ns = 0;
+    std::uint64_t output_ns = 0;
+
+    void note_queue(std::size_t size) {
+        if (size > pq_high_water) pq_high_water = size;
+        pq_size_sum += static_cast<double>(size);
+    }
+
+    // Handler-side counters only; lanes fold theirs into the simulator after each window
+    void add_handlers(const PerfStats& o) {
+        for (int i = 0; i < kNumEventTypes; ++i) {
+            event_counts[i] += o.event_counts[i];
+            handler_ns[i] += o.handler_ns[i];
+        }
+        events_processed += o.events_processed;
+        events_cancelled += o.events_cancelled;
+        dead_events_skipped += o.dead_events_skipped;
+    }
+};
+
+#ifdef KV_SIM_PROFILE
+constexpr bool kProfilingEnabled = true;
+
+class ScopedTimer {
+public:
+    explicit ScopedTimer(std::uint64_t& acc) : acc_(acc), start_(std::chrono::steady_clock::now()) {}
+    ~ScopedTimer() {
+        acc_ += static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start_).count());
+    }
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+private:
+    std::uint64_t& acc_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+#define KV_PROF_CAT2(a, b) a##b
+#define KV_PROF_CAT(a, b) KV_PROF_CAT2(a, b)
+#define KV_PROF_TIMER(acc) ScopedTimer KV_PROF_CAT(kv_prof_timer_, __LINE__)(acc)
+#define KV_PROF(stmt) stmt
+#else
+constexpr bool kProfilingEnabled = false;
+
+#define KV_PROF_TIMER(acc) ((void)0)
+#define KV_PROF(stmt) ((void)0)
+#endif
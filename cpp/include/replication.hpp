@@ -0,0 +1,44 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "types.hpp"
+
+// Monte Carlo replications: the same config and trace under independent Philox streams
+// (SimConfig::replication = 0, 1, 2, ...), run across threads.
+struct ReplicationOptions {
+    int max_replications = 10;
+    int min_replications = 5;     // CIs need a few samples before the stop rule applies
+    int threads = 1;
+    double ci_level = 0.95;
+    double ci_target = 0.0;       // stop once every half-width <= ci_target * |mean| (0 = run all)
+};
+
+// Headline metrics of one replication, computed like summary.json
+struct ReplicationSample {
+    double p50_latency_ms = 0.0;
+    double p99_latency_ms = 0.0;
+    double throughput_tokens_per_sec = 0.0;
+    double reject_rate = 0.0;
+};
+
+struct MetricEstimate {
+    std::string name;
+    double mean = 0.0;
+    double stddev = 0.0;
+    double half_width = 0.0;  // Student-t interval at ReplicationOptions::ci_level
+};
+
+struct ReplicationResult {
+    std::vector<ReplicationSample> samples;  // in replication index order
+    std::vector<MetricEstimate> estimates;
+    bool converged = false;
+};
+
+// The stop rule is evaluated on replication-index prefixes, so the replication count and
+// every estimate are identical for any thread count. Replications started past the stop
+// point are discarded.
+bool run_replications(const SimConfig& cfg, const std::vector<Request>& requests,
+                      const ReplicationOptions& opts, ReplicationResult& result, std::string& err);
+
+// Two-sided Student-t critical value for the given confidence level
+double student_t_critical(double level, int dof);
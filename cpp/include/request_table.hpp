@@ -0,0 +1,86 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "types.hpp"
+
+// Simulation-side request storage. Request is the trace record; the simulator keeps
+// per-request state split by access pattern instead:
+//  - RequestHot: everything the event handlers, schedulers and routers touch, packed
+//    into one cache line per request
+//  - cold columns: ids, timestamps only written once or read by the reports, and the
+//    speculative-decoding fields, each in its own array
+// Tenant, model and session names are resolved to indices at construction and not kept.
+struct alignas(64) RequestHot {
+    double start_decode_ms = 0.0;
+    double decode_end_ms = 0.0;  // scheduled finish of the current decode, for KV growth timing
+    std::int32_t prompt_tokens = 0;
+    std::int32_t gen_tokens = 0;
+    std::int32_t predicted_gen_tokens = 0;  // what schedulers and reservation see instead of gen_tokens
+    std::int32_t cached_tokens = 0;  // prompt tokens served from the session's retained KV
+    std::int32_t tenant_idx = 0;
+    std::int32_t model_idx = 0;
+    std::int32_t prefill_gpu = 0;
+    std::int32_t decode_gpu = 0;
+    std::int32_t pending_events = 0;      // queued cancellable events of the current generation
+    std::uint32_t event_generation = 0;   // bumped when the request leaves; older events are dead
+    std::int16_t priority = 0;
+    std::int16_t retry_count = 0;
+    RequestState state = RequestState::Arrived;
+};
+static_assert(kMaxPriority <= INT16_MAX, "request classes must fit RequestHot::priority");
+static_assert(sizeof(RequestHot) == 64, "RequestHot should fill exactly one cache line");
+
+struct RequestSpec {
+    double acceptance = 0.0;           // per-token draft acceptance rate
+    double steps = 0.0;                // expected target steps of the current decode
+    std::uint64_t draft_kv_bytes = 0;  // draft-model KV held on the decode GPU
+};
+
+struct RequestTable {
+    std::vector<RequestHot> hot;
+    std::vector<std::string> id;
+    std::vector<double> arrival_ms;
+    std::vector<double> start_prefill_ms;
+    std::vector<double> finish_ms;
+    std::vector<RequestSpec> spec;
+    std::vector<std::int32_t> session;  // index into the simulator's sessions (-1 = none)
+    std::vector<std::int32_t> turn;
+    std::vector<double> timeout_ms;  // trace column; the simulator fills in the policy default
+
+    RequestTable() = default;
+    explicit RequestTable(const std::vector<Request>& trace) { assign(trace); }
+
+    // Fresh state for trace, reusing the columns' storage (and the id strings') from
+    // the previous run
+    void assign(const std::vector<Request>& trace) {
+        std::size_t n = trace.size();
+        hot.assign(n, RequestHot{});
+        id.resize(n);
+        arrival_ms.resize(n);
+        start_prefill_ms.assign(n, 0.0);
+        finish_ms.assign(n, 0.0);
+        spec.assign(n, RequestSpec{});
+        session.assign(n, -1);
+        turn.resize(n);
+        timeout_ms.resize(n);
+        for (std::size_t i = 0; i < n; ++i) {
+            const Request& r = trace[i];
+            hot[i].prompt_tokens = r.prompt_tokens;
+            hot[i].gen_tokens = r.gen_tokens;
+            // Requests built in code skip the trace parser's range check
+            hot[i].priority = static_cast<std::int16_t>(std::clamp(r.priority, 0, kMaxPriority));
+            id[i] = r.id;
+            arrival_ms[i] = r.arrival_time_ms;
+            turn[i] = r.turn;
+            timeout_ms[i] = r.timeout_ms;
+        }
+    }
+
+    std::size_t size() const { return hot.size(); }
+    bool empty() const { return hot.empty(); }
+    RequestHot& operator[](std::size_t i) { return hot[i]; }
+    const RequestHot& operator[](std::size_t i) const { return hot[i]; }
+};
@@ -0,0 +1,33 @@
+#pragma once
+// Content-addressed cache of run outputs (summary.json, timeseries.csv, events.jsonl and
+// any flight-recorder dumps the summary lists).
+// Keys cover the parsed trace, the effective SimConfig rather than the config file bytes,
+// the seed and the simulator build, so any config spelling that parses to the same
+// settings shares an entry and a rebuilt simulator never serves stale results.
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "types.hpp"
+
+// Project version plus a hash of the binary (executable or shared object) holding the core
+const std::string& kv_sim_build_id();
+
+// Effective settings only; the seed is keyed separately
+std::uint64_t hash_config(const SimConfig& cfg);
+std::uint64_t hash_trace(const std::vector<Request>& requests);
+std::string cache_key(const SimConfig& cfg, const std::vector<Request>& requests);
+
+class ResultCache {
+public:
+    explicit ResultCache(std::string dir) : dir_(std::move(dir)) {}
+
+    // Copies a cached entry into out_dir; false on a miss
+    bool fetch(const std::string& key, const std::string& out_dir) const;
+    // Saves out_dir's outputs under key. Entries appear atomically, so concurrent
+    // writers of the same key are safe.
+    bool store(const std::string& key, const std::string& out_dir, std::string& err) const;
+    std::string entry_dir(const std::string& key) const { return dir_ + "/" + key; }
+
+private:
+    std::string dir_;
+};
@@ -1,12 +1,118 @@
 #pragma once
+#include <array>
+#include <cstdint>
+#include <istream>
+#include <ostream>
 #include <random>
+#include <sstream>
+#include <string>
+
+// Philox4x32-10 counter-based engine (Salmon et al., SC'11). Output block n is a pure
+// function of (key, n), so each (seed, stream) pair is an independent, reproducible
+// sequence no matter which thread draws it or in what order streams are created.
+class Philox4x32 {
+public:
+    using result_type = std::uint32_t;
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return 0xffffffffu; }
+
+    Philox4x32() = default;
+    Philox4x32(std::uint32_t seed, std::uint32_t stream) : key_{seed, stream} {}
+
+    result_type operator()() {
+        if (idx_ == 4) {
+            block_ = generate(counter_++);
+            idx_ = 0;
+        }
+        return block_[idx_++];
+    }
+
+    friend std::ostream& operator<<(std::ostream& os, const Philox4x32& p) {
+        return os << p.key_[0] << ' ' << p.key_[1] << ' ' << p.counter_ << ' ' << p.idx_;
+    }
+    friend std::istream& operator>>(std::istream& is, Philox4x32& p) {
+        is >> p.key_[0] >> p.key_[1] >> p.counter_ >> p.idx_;
+        if (is && p.idx_ < 4) p.block_ = p.generate(p.counter_ - 1);
+        return is;
+    }
+
+private:
+    std::array<std::uint32_t, 4> generate(std::uint64_t n) const {
+        std::array<std::uint32_t, 4> c = {static_cast<std::uint32_t>(n), static_cast<std::uint32_t>(n >> 32), 0u, 0u};
+        std::uint32_t k0 = key_[0];
+        std::uint32_t k1 = key_[1];
+        for (int round = 0; round < 10; ++round) {
+            std::uint64_t p0 = static_cast<std::uint64_t>(0xD2511F53u) * c[0];
+            std::uint64_t p1 = static_cast<std::uint64_t>(0xCD9E8D57u) * c[2];
+            c = {static_cast<std::uint32_t>(p1 >> 32) ^ c[1] ^ k0, static_cast<std::uint32_t>(p1),
+                 static_cast<std::uint32_t>(p0 >> 32) ^ c[3] ^ k1, static_cast<std::uint32_t>(p0)};
+            k0 += 0x9E3779B9u;
+            k1 += 0xBB67AE85u;
+        }
+        return c;
+    }
+
+    std::array<std::uint32_t, 2> key_{0u, 0u};
+    std::uint64_t counter_ = 0;
+    std::array<std::uint32_t, 4> block_{};
+    unsigned idx_ = 4;
+};
 
 class RNG {
 public:
     explicit RNG(unsigned int seed) : gen_(seed) {}
-    double uniform01() { return dist_(gen_); }
+    // Counter-based stream; used by replications so runs do not depend on thread scheduling
+    RNG(unsigned int seed, std::uint32_t stream) : counter_based_(true), philox_(seed, stream) {}
+
+    double uniform01() { return draw(dist_); }
+    double normal01() { return draw(normal_); }
+
+    template <class Dist>
+    typename Dist::result_type draw(Dist& d) {
+        return counter_based_ ? d(philox_) : d(gen_);
+    }
+
+    // Engine and distribution state in the standard textual form, for checkpoints
+    std::string state() const {
+        std::ostringstream os;
+        if (counter_based_) {
+            os << "philox " << philox_;
+        } else {
+            os << gen_;
+        }
+        os << ' ' << dist_ << ' ' << normal_;
+        return os.str();
+    }
+    bool set_state(const std::string& s) {
+        std::istringstream is(s);
+        counter_based_ = s.compare(0, 7, "philox ") == 0;
+        if (counter_based_) {
+            std::string tag;
+            is >> tag >> philox_;
+        } else {
+            is >> gen_;
+        }
+        is >> dist_ >> normal_;
+        return !is.fail();
+    }
 
 private:
+    bool counter_based_ = false;
     std::mt19937 gen_;
+    Philox4x32 philox_;
     std::uniform_real_distribution<double> dist_{0.0, 1.0};
+    std::normal_distribution<double> normal_{0.0, 1.0};
 };
+
+// Consumers of randomness, each with its own stream so enabling one feature leaves
+// the others' draws untouched
+enum class RngStream : std::uint32_t { Routing = 0, LengthPredictor = 1, SpecAcceptance = 2, Count = 4 };
+
+// replication < 0 keeps the historical mt19937 seeding (seed ^ legacy_salt); otherwise
+// the stream is Philox keyed by (seed, replication * Count + purpose).
+inline RNG make_rng(unsigned int seed, int replication, RngStream purpose, unsigned int legacy_salt) {
+    if (replication < 0) return RNG(seed ^ legacy_salt);
+    auto stream = static_cast<std::uint32_t>(replication) * static_cast<std::uint32_t>(RngStream::Count) +
+                  static_cast<std::uint32_t>(purpose);
+    return RNG(seed, stream);
+}
@@ -0,0 +1,67 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+
+// Memory resource for per-run node containers (a GPU's LRU list). Nodes come from a
+// pool carved out of a monotonic buffer, so freed nodes are recycled within the run.
+// release() drops everything at once; if the run spilled past the buffer, the buffer
+// grows to the run's high-water mark, so the next run of similar size makes no
+// system allocations. Not thread-safe: each GPU owns its arena, and parallel lanes
+// never share a GPU.
+class RunArena : public std::pmr::memory_resource {
+public:
+    RunArena() { rebuild(); }
+    RunArena(const RunArena&) = delete;
+    RunArena& operator=(const RunArena&) = delete;
+
+    // Every container using the arena must be empty
+    void release() {
+        pool_.reset();
+        mono_.reset();
+        if (spill_.bytes > 0) {
+            size_ += spill_.bytes;
+            buffer_.reset(new std::byte[size_]);
+            spill_.bytes = 0;
+        }
+        rebuild();
+    }
+    std::size_t capacity() const { return size_; }
+
+private:
+    // Heap fallback once the buffer is exhausted; remembers how much was needed
+    class Spill : public std::pmr::memory_resource {
+    public:
+        std::size_t bytes = 0;
+
+    private:
+        void* do_allocate(std::size_t n, std::size_t align) override {
+            bytes += n;
+            return std::pmr::new_delete_resource()->allocate(n, align);
+        }
+        void do_deallocate(void* p, std::size_t n, std::size_t align) override {
+            std::pmr::new_delete_resource()->deallocate(p, n, align);
+        }
+        bool do_is_equal(const std::pmr::memory_resource& o) const noexcept override { return this == &o; }
+    };
+
+    void rebuild() {
+        if (size_ > 0) {
+            mono_.emplace(buffer_.get(), size_, &spill_);
+        } else {
+            mono_.emplace(&spill_);
+        }
+        pool_.emplace(&*mono_);
+    }
+
+    void* do_allocate(std::size_t n, std::size_t align) override { return pool_->allocate(n, align); }
+    void do_deallocate(void* p, std::size_t n, std::size_t align) override { pool_->deallocate(p, n, align); }
+    bool do_is_equal(const std::pmr::memory_resource& o) const noexcept override { return this == &o; }
+
+    std::unique_ptr<std::byte[]> buffer_;
+    std::size_t size_ = 0;
+    Spill spill_;
+    std::optional<std::pmr::monotonic_buffer_resource> mono_;
+    std::optional<std::pmr::unsynchronized_pool_resource> pool_;
+};
@@ -1,50 +1,267 @@
 #pragma once
+#include <atomic>
+#include <iosfwd>
+#include <string>
 #include <vector>
 #include <queue>
 #include <deque>
 #include <list>
+#include "global_queue.hpp"
 #include "types.hpp"
+#include "request_table.hpp"
 #include "events.hpp"
+#include "flight_recorder.hpp"
 #include "rng.hpp"
+#include "profiler.hpp"
+#include "timer_wheel.hpp"
+
+class ChromeTraceWriter;
 
 class Simulator {
 public:
     Simulator(SimConfig cfg, std::vector<Request> requests);
+    // Starts over with a new config and trace, as if freshly constructed, but keeps the
+    // storage reserved by earlier runs (queues, logs, per-request and per-GPU state).
+    // Sweeps reuse one Simulator per thread this way.
+    void reset(SimConfig cfg, const std::vector<Request>& requests);
     void run();
-    const std::vector<Request>& requests() const { return requests_; }
-    const std::vector<EventRecord>& events() const { return events_; }
+    // Process every event with time <= t_ms; run() continues from wherever this stopped
+    void run_until(double t_ms);
+    // Process at most max_events events; returns how many ran (0 once idle)
+    std::size_t run_for(std::size_t max_events);
+    // Cooperative cancellation: the run loops return at the next event once *flag is set.
+    // The flag must outlive the runs; nullptr disables the check.
+    void set_stop_flag(const std::atomic<bool>* flag) { stop_flag_ = flag; }
+    double now_ms() const { return now_ms_; }
+    // True once started and no events remain
+    bool idle() const { return started_ && pq_.empty(); }
+    // Quiet mode for batch runs (replications); suppresses the end-of-run totals line
+    void set_verbose(bool verbose) { verbose_ = verbose; }
+
+    // Binary snapshot of the full dynamic state. Restore into a Simulator built from the
+    // same trace and GPU count; policy settings may differ for what-if continuations.
+    bool save_checkpoint(std::ostream& os, std::string& err) const;
+    bool load_checkpoint(std::istream& is, std::string& err);
+    bool save_checkpoint(const std::string& path, std::string& err) const;
+    bool load_checkpoint(const std::string& path, std::string& err);
+    const RequestTable& requests() const { return requests_; }
+    // The full log, or the flight recorder's current window when that is enabled
+    const std::vector<EventRecord>& events() const { return flight_.enabled() ? flight_.window() : events_; }
+    FlightRecorder& flight_recorder() { return flight_; }
+    // Streams the Chrome trace-event timeline (trace_export.hpp) while the run executes,
+    // so it sees every record even when the flight recorder keeps only a window. Records
+    // and samples already logged are replayed into it first. The writer must outlive the
+    // runs; nullptr detaches it, as does reset().
+    void set_trace_writer(ChromeTraceWriter* writer);
+    const FlightRecorder& flight_recorder() const { return flight_; }
     const std::vector<TimeseriesSample>& samples() const { return samples_; }
     double sim_end_ms() const { return sim_end_ms_; }
-    std::uint64_t tokens_generated_total() const { return tokens_generated_total_; }
+    std::uint64_t tokens_generated_total() const { return ctr_.tokens_generated; }
+
+    // Conservative parallel engine: GPUs are split into `threads` partitions whose
+    // partition-local events run concurrently. Output is identical to run().
+    void run_parallel(int threads);
 
     // Phase 8: Extended metrics getters
     int retry_attempts() const { return retry_attempts_; }
     int retry_successes() const { return retry_successes_; }
     int handoffs_total() const { return handoffs_total_; }
-    int cross_gpu_decodes() const { return cross_gpu_decodes_; }
+    int handoffs_pipelined() const { return handoffs_pipelined_; }
+    double handoff_whole_ms() const { return handoff_whole_ms_; }
+    double handoff_exposed_ms() const { return handoff_exposed_ms_; }
+    int cross_gpu_decodes() const { return ctr_.cross_gpu_decodes; }
     int max_global_queue_depth() const { return max_global_queue_depth_; }
+    int global_backfills() const { return global_backfills_; }
+    int kv_growth_steps() const { return ctr_.kv_growth_steps; }
+    int kv_growth_failures() const { return ctr_.kv_growth_failures; }
+    double spec_steps_total() const { return ctr_.spec_steps; }
+    std::uint64_t spec_tokens_total() const { return ctr_.spec_tokens; }
+    int spec_fallbacks() const { return ctr_.spec_fallbacks; }
+    int session_followups() const { return ctr_.session_followups; }
+    int session_hits() const { return ctr_.session_hits; }
+    std::uint64_t session_reused_tokens() const { return ctr_.session_reused_tokens; }
+    double session_prefill_saved_ms() const { return ctr_.session_prefill_saved_ms; }
+    int session_retained() const { return ctr_.session_retained; }
+    int session_expired() const { return ctr_.session_expired; }
+    int session_pressure_drops() const { return ctr_.session_pressure_drops; }
+    int evictions() const { return ctr_.evictions; }
+    bool timeouts_enabled() const { return timers_.enabled(); }
+    int abandoned_queued() const { return abandoned_queued_; }
+    int abandoned_prefill() const { return abandoned_prefill_; }
+    int abandoned_decode() const { return abandoned_decode_; }
+    double abandoned_prefill_ms() const { return abandoned_prefill_ms_; }
+    double abandoned_decode_tokens() const { return abandoned_decode_tokens_; }
+    int num_sessions() const { return static_cast<int>(sessions_.size()); }
     const std::vector<std::uint64_t>& peak_vram_per_gpu() const { return peak_vram_per_gpu_; }
     const std::vector<std::uint64_t>& tokens_per_gpu() const { return tokens_per_gpu_; }
     const std::vector<int>& requests_finished_per_gpu() const { return requests_finished_per_gpu_; }
     int num_gpus() const { return static_cast<int>(gpus_.size()); }
+    const std::vector<TenantState>& tenants() const { return tenants_; }
+    const std::vector<ModelState>& models() const { return models_; }
+    const PerfStats& perf_stats() const { return perf_; }
 
 private:
-    int route_gpu_for_request(const Request& req);
+    friend struct SimulatorBenchAccess;  // bench/bench_main.cpp drives private hot paths
+
+    // Counters that partition-local handlers update; lanes buffer them per event
+    struct SimCounters {
+        std::uint64_t tokens_generated = 0;
+        int rejects = 0;
+        int cross_gpu_decodes = 0;
+        int kv_growth_steps = 0;
+        int kv_growth_failures = 0;
+        double spec_steps = 0.0;
+        std::uint64_t spec_tokens = 0;
+        int spec_fallbacks = 0;
+        int session_followups = 0;  // placed turns after a session's first
+        int session_hits = 0;
+        std::uint64_t session_reused_tokens = 0;
+        double session_prefill_saved_ms = 0.0;
+        int session_retained = 0;
+        int session_expired = 0;
+        int session_pressure_drops = 0;
+        int evictions = 0;
+        double last_request_event_ms = 0.0;  // latest event other than a session expiry
+        void add(const SimCounters& o);
+    };
+
+    // Load figures a timeseries sample reads from one GPU
+    struct GpuLoad {
+        std::uint64_t vram_used = 0;
+        int active_prefill = 0;
+        int active_decode = 0;
+        int queue_depth = 0;
+    };
+
+    // One event handled inside a parallel window, replayed in global order afterwards
+    struct LaneStep {
+        Event event;
+        int gpus[2] = {-1, -1};  // GPUs whose load changed (HandoffComplete touches two)
+        GpuLoad loads[2];
+        SimCounters ctr;
+        std::size_t records_begin = 0;
+        std::size_t records_end = 0;
+    };
+
+    // Execution context of one GPU partition in the parallel engine
+    struct Lane {
+        double now_ms = 0.0;
+        EventQueue pq;               // partition-local events
+        std::vector<Event> outbox;   // global events created inside a window
+        std::vector<EventRecord> records;
+        std::vector<LaneStep> steps;
+        std::vector<int> tenant_releases;
+        std::int64_t dead_delta = 0;  // change in dead queued events, folded in after the window
+        SimCounters ctr;
+        PerfStats perf;
+
+        // Empties the lane for a new run, keeping its storage
+        void reset(std::size_t num_tenants) {
+            now_ms = 0.0;
+            pq.clear();
+            outbox.clear();
+            records.clear();
+            steps.clear();
+            tenant_releases.assign(num_tenants, 0);
+            dead_delta = 0;
+            ctr = SimCounters{};
+            perf = PerfStats{};
+        }
+    };
+
+    static thread_local Lane* active_lane_;
+
+    double now() const { return active_lane_ ? active_lane_->now_ms : now_ms_; }
+    SimCounters& ctr() { return active_lane_ ? active_lane_->ctr : ctr_; }
+    PerfStats& perf() { return active_lane_ ? active_lane_->perf : perf_; }
+    void push_event(const Event& e);
+    // Routes an already stamped event to its queue (sequential, lane or global)
+    void enqueue_event(const Event& e);
+    bool is_global_event(const Event& e) const;
+    // Event cancellation: a request leaving the system bumps its generation, which kills
+    // its queued cancellable events. Dead events are skipped on pop without advancing the
+    // clock, and the queues are compacted once dead entries dominate.
+    bool event_dead(const Event& e) const {
+        return event_cancellable(e.type) && e.generation != requests_[e.request_index].event_generation;
+    }
+    bool take_event(const Event& e);
+    void cancel_pending_events(int req_idx);
+    void note_dead_events(std::int64_t delta);
+    void maybe_compact_events();
+    GpuLoad load_of(int gpu_idx) const;
+    double parallel_lookahead_ms() const;
+    bool next_parallel_event(Event& out, bool& from_global);
+    void run_lane_window(Lane& lane, double window_end);
+    void replay_window(std::vector<GpuLoad>& view);
+    void report_totals();
+
+    void init_tenants(const std::vector<Request>& trace);
+    bool admit_tenant(const RequestHot& req);
+    void release_tenant_slot(const RequestHot& req);
+    double predict_ttft_ms(const RequestHot& req, int gpu_idx) const;
+    void reject_at_arrival(int req_idx, int gpu_idx);
+
+    // Models: placement, weights residency and per-model KV geometry
+    void init_models(const std::vector<Request>& trace);
+    std::uint64_t kv_bytes_per_token(const RequestHot& req) const { return models_[req.model_idx].cfg.kv_bytes_per_token; }
+    bool serves_model(int gpu_idx, const RequestHot& req) const { return models_[req.model_idx].on_gpu[gpu_idx] != 0; }
+    // Bytes the model's weights still need on gpu_idx (0 once resident)
+    std::uint64_t weights_to_load(int gpu_idx, const RequestHot& req) const;
+    void load_weights(int gpu_idx, int model_idx, double ready_ms);
+    void ensure_model_loaded(int gpu_idx, const RequestHot& req);
+
+    int route_gpu_for_request(int req_idx);
     void schedule_arrivals();
     void handle_event(const Event& event);
     void on_arrival(const Event& event);
     void on_start_prefill(const Event& event);
     void on_start_decode(const Event& event);
     void on_finish(const Event& event);
+    void on_kv_grow(const Event& event);
+    void on_session_expire(const Event& event);
+
+    // Client timeouts: each admitted request's deadline goes into timers_, which one
+    // TimerTick event at a time expands into Abandon events for the requests still
+    // there. Both are global events.
+    void init_timeouts();
+    void arm_timeout(int req_idx);
+    void arm_deadline(int req_idx, double deadline_ms);
+    void on_timer_tick(const Event& event);
+    void on_abandon(const Event& event);
+    // Drops a request wherever it is: queued, prefilling, handing off or decoding
+    void abandon_request(int req_idx);
+
+    // Multi-turn sessions: a finished turn's KV stays on its decode GPU for
+    // session_kv_ttl_ms, and the next turn placed there skips that part of its prefill
+    void init_sessions(const std::vector<Request>& trace);
+    void claim_session_kv(int req_idx, int gpu_idx);
+    void retain_session_kv(int req_idx, int gpu_idx);
+    void drop_session_kv(int session_idx);
+    int prefer_session_gpu(int req_idx, int pick) const;
 
     void try_start_prefill(int gpu_idx);
+    void enqueue_prefill(int req_idx, int gpu_idx);
     int pick_next_from_queue(int gpu_idx);
-    void record_event(EventType type, const Request& req, int gpu_idx);
+    void drop_eviction_tracking(int req_idx, int gpu_idx);
+    void record_event(EventType type, int req_idx, int gpu_idx);
+    // Appends to the event log or the flight recorder, in global event order
+    void log_record(EventRecord r);
     void sample_until(double time_ms);
+    void start_if_needed();
+    bool process_next_event();
+    bool stop_requested() const { return stop_flag_ && stop_flag_->load(std::memory_order_relaxed); }
 
-    double prefill_duration_ms(int prompt_tokens, int gpu_idx) const;
-    double decode_duration_ms(int gen_tokens, int active_decode, int gpu_idx) const;
+    double prefill_duration_ms(const RequestHot& req, int gpu_idx) const;
+    double decode_duration_ms(const RequestHot& req, int active_decode, int gpu_idx) const;
     bool can_admit_prompt(int prompt_tokens, int gpu_idx) const;
+    int reserved_gen_tokens(const RequestHot& req) const;
+    int reserved_gen_on(int req_idx, int gpu_idx) const;
+    void schedule_kv_growth(int req_idx, int gpu_idx);
+    void schedule_decode_finish(int req_idx, int gpu_idx);
+
+    void init_spec_acceptance();
+    bool start_speculation(int req_idx, int gpu_idx);
+    double spec_decode_duration_ms(int req_idx, int active_decode, int gpu_idx, double& steps) const;
     bool can_reserve_decode(int prompt_tokens, int gen_tokens, int gpu_idx) const;
     void allocate_kv_bytes(int req_idx, std::uint64_t bytes, int gpu_idx);
     void free_kv_bytes(int req_idx, std::uint64_t bytes, int gpu_idx);
@@ -55,35 +272,60 @@ private:
 
     double score_gpu(int gpu_idx) const;
 
-    int route_decode(int prefill_gpu, const Request& req);
+    int route_decode(int prefill_gpu, const RequestHot& req);
     void on_handoff_start(const Event& event);
     void on_handoff_complete(const Event& event);
 
     void precompute_topology();
-    bool can_fit_kv(int gpu_idx, const Request& req) const;
+    // Hierarchical topology (cfg_.hierarchy.gpus_per_node > 0): O(depth) path costs and
+    // a two-level router that picks a node, then a GPU inside it
+    bool hierarchical() const { return cfg_.hierarchy.gpus_per_node > 0; }
+    int num_nodes() const;
+    int node_of(int gpu_idx) const { return gpu_idx / cfg_.hierarchy.gpus_per_node; }
+    const TopologyLevel& path_level(int src_gpu_idx, int dest_gpu_idx) const;
+    double node_score(int node) const;
+    int sample_index(int n);
+    int route_arrival_hierarchical(const RequestHot& req);
+    int route_decode_hierarchical(int prefill_gpu, const RequestHot& req);
+    bool can_fit_kv(int gpu_idx, const RequestHot& req) const;
     double get_link_bandwidth(int src_gpu_idx, int dest_gpu_idx) const;
     double get_link_latency(int src_gpu_idx, int dest_gpu_idx) const;
-    double estimate_handoff_ms(int src_gpu_idx, int dest_gpu_idx, const Request& req) const;
-    double compute_decode_score(int src_gpu_idx, int dest_gpu_idx, const Request& req) const;
+    double estimate_handoff_ms(int src_gpu_idx, int dest_gpu_idx, const RequestHot& req) const;
+    // Handoff time still left when prefill on src ends (the whole copy unless layerwise)
+    double handoff_tail_ms(int src_gpu_idx, int dest_gpu_idx, const RequestHot& req) const;
+    double compute_decode_score(int src_gpu_idx, int dest_gpu_idx, const RequestHot& req) const;
 
     void try_dispatch_global_queue();
-    int find_alternate_gpu(int exclude_gpu, const Request& req) const;
+    void enqueue_global(int req_idx, double enqueued_ms);
+    int find_alternate_gpu(int exclude_gpu, const RequestHot& req) const;
 
 private:
     SimConfig cfg_;
-    std::vector<Request> requests_;
+    RequestTable requests_;
     std::vector<GPUState> gpus_;
-    std::priority_queue<Event, std::vector<Event>, EventCompare> pq_;
+    EventQueue pq_;
     std::vector<EventRecord> events_;
+    FlightRecorder flight_;
     std::vector<TimeseriesSample> samples_;
-    std::deque<int> global_queue_;
+    GlobalQueue global_queue_;
+    std::vector<TenantState> tenants_;
+    std::vector<ModelState> models_;
+    std::vector<SessionState> sessions_;
+    TimerWheel timers_;
+    double next_tick_ms_ = 0.0;  // earliest TimerTick queued (infinity when none)
+    std::vector<TimerWheel::Entry> expired_;
 
+    bool started_ = false;
+    bool verbose_ = true;
+    const std::atomic<bool>* stop_flag_ = nullptr;
+    ChromeTraceWriter* trace_writer_ = nullptr;
     double now_ms_ = 0.0;
     double next_sample_ms_ = 0.0;
+    std::int64_t dead_events_ = 0;  // cancelled events still sitting in the queues
     double sim_end_ms_ = 0.0;
 
-    std::uint64_t tokens_generated_total_ = 0;
-    int rejects_total_ = 0;
+    SimCounters ctr_;
+    PerfStats perf_;
     std::uint64_t last_tokens_sampled_ = 0;
     int last_rejects_sampled_ = 0;
 
@@ -91,11 +333,26 @@ private:
     int retry_attempts_ = 0;
     int retry_successes_ = 0;
     int handoffs_total_ = 0;
-    int cross_gpu_decodes_ = 0;
+    int handoffs_pipelined_ = 0;
+    double handoff_whole_ms_ = 0.0;    // what the pipelined handoffs would have cost as one copy
+    double handoff_exposed_ms_ = 0.0;  // what they cost after prefill ended
     int max_global_queue_depth_ = 0;
+    int global_backfills_ = 0;  // dispatches that overtook an older, blocked waiter
+    int abandoned_queued_ = 0;   // timed out in the global or a prefill queue
+    int abandoned_prefill_ = 0;  // timed out in prefill or the handoff after it
+    int abandoned_decode_ = 0;
+    double abandoned_prefill_ms_ = 0.0;     // prefill time spent on requests that then timed out
+    double abandoned_decode_tokens_ = 0.0;  // tokens decoded for requests that then timed out
     std::vector<std::uint64_t> peak_vram_per_gpu_;
     std::vector<std::uint64_t> tokens_per_gpu_;
     std::vector<int> requests_finished_per_gpu_;
 
+    // Parallel engine state (empty unless run_parallel is active)
+    bool parallel_ = false;
+    std::vector<Lane> lanes_;
+    std::vector<int> gpu_partition_;
+    EventQueue global_events_;
+    const std::vector<GpuLoad>* sample_view_ = nullptr;
+
     RNG rng_;
 };
\ No newline at end of file
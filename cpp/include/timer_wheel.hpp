@@ -0,0 +1,95 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+// Client deadlines of requests in flight, hashed by deadline into kSlots buckets of
+// tick_ms each. The simulator keeps a single wake-up event at the earliest non-empty
+// bucket and expands that bucket when it fires, so only deadlines whose request is
+// still in the system turn into events. A request that finishes first is never
+// unlinked: its entry is dropped when its bucket comes due. Arming a timer that never
+// fires thus costs one push and no event.
+class TimerWheel {
+public:
+    static constexpr std::int64_t kSlots = 256;
+
+    struct Entry {
+        double deadline_ms = 0.0;
+        int req_idx = -1;
+    };
+
+    // Empties the wheel for a new run, keeping its storage; tick_ms <= 0 disables it
+    void reset(double tick_ms) {
+        tick_ms_ = tick_ms;
+        slots_.resize(kSlots);
+        for (auto& s : slots_) s.clear();
+        size_ = 0;
+        cursor_ = 0;
+    }
+
+    bool enabled() const { return tick_ms_ > 0.0; }
+    double tick_ms() const { return tick_ms_; }
+    std::size_t size() const { return size_; }
+    std::int64_t bucket_of(double t_ms) const { return static_cast<std::int64_t>(std::floor(t_ms / tick_ms_)); }
+    double bucket_start(std::int64_t b) const { return static_cast<double>(b) * tick_ms_; }
+
+    // Buckets before the cursor have been expanded
+    std::int64_t cursor() const { return cursor_; }
+    void set_cursor(std::int64_t b) { cursor_ = b; }
+
+    // False when the deadline's bucket was already expanded; the caller fires it directly
+    bool insert(double deadline_ms, int req_idx, double now_ms) {
+        // An idle wheel skips ahead so deadlines stay within one turn of the cursor
+        if (size_ == 0) cursor_ = std::max(cursor_, bucket_of(now_ms));
+        std::int64_t b = bucket_of(deadline_ms);
+        if (b < cursor_) return false;
+        slots_[static_cast<std::size_t>(b % kSlots)].push_back(Entry{deadline_ms, req_idx});
+        ++size_;
+        return true;
+    }
+
+    // Earliest bucket holding an entry (-1 when empty)
+    std::int64_t next_bucket() const {
+        if (size_ == 0) return -1;
+        for (std::int64_t b = cursor_; b < cursor_ + kSlots; ++b) {
+            for (const auto& e : slots_[static_cast<std::size_t>(b % kSlots)]) {
+                if (bucket_of(e.deadline_ms) == b) return b;
+            }
+        }
+        // Everything is more than a turn out
+        std::int64_t best = std::numeric_limits<std::int64_t>::max();
+        for (const auto& s : slots_) {
+            for (const auto& e : s) best = std::min(best, bucket_of(e.deadline_ms));
+        }
+        return best;
+    }
+
+    // Moves bucket b's entries into out (replacing its contents) and advances past b.
+    // b must be next_bucket().
+    void expand(std::int64_t b, std::vector<Entry>& out) {
+        out.clear();
+        auto& s = slots_[static_cast<std::size_t>(b % kSlots)];
+        auto later = std::stable_partition(s.begin(), s.end(), [&](const Entry& e) { return bucket_of(e.deadline_ms) != b; });
+        out.assign(later, s.end());
+        s.erase(later, s.end());
+        size_ -= out.size();
+        cursor_ = b + 1;
+    }
+
+    // Every entry, slot by slot (for checkpoints)
+    std::vector<Entry> entries() const {
+        std::vector<Entry> out;
+        out.reserve(size_);
+        for (const auto& s : slots_) out.insert(out.end(), s.begin(), s.end());
+        return out;
+    }
+
+private:
+    double tick_ms_ = 0.0;
+    std::vector<std::vector<Entry>> slots_;
+    std::size_t size_ = 0;
+    std::int64_t cursor_ = 0;
+};
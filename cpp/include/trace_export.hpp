@@ -0,0 +1,78 @@
+#pragma once
+// Chrome trace-event export of a run: the JSON format that ui.perfetto.dev and
+// chrome://tracing open directly, with no conversion step.
+//  - one process per GPU; each request in flight holds a numbered slot (a thread
+//    track) for its prefill, handoff and decode spans, so concurrent requests never
+//    overlap on a track
+//  - per-GPU counters for VRAM (from the timeseries), queued requests and active
+//    prefill/handoff/decode spans; a "cluster" process carries the timeseries'
+//    queue depths
+//  - rejects, evictions and client timeouts are instant events on the slot they hit
+// Spans are written when they close, so the writer's memory is bounded by the requests in
+// flight rather than the length of the run. Attach it with Simulator::set_trace_writer to
+// stream a run as it executes; the whole-run forms below need the full event log.
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "types.hpp"
+
+class ChromeTraceWriter {
+public:
+    ChromeTraceWriter(std::ostream& os, int num_gpus);
+    ~ChromeTraceWriter();
+    ChromeTraceWriter(const ChromeTraceWriter&) = delete;
+    ChromeTraceWriter& operator=(const ChromeTraceWriter&) = delete;
+
+    // Records must arrive in log order (events.jsonl order); samples in time order
+    void add_event(const EventRecord& e);
+    void add_sample(const TimeseriesSample& s);
+    // Closes spans still open at the last timestamp seen and ends the JSON document.
+    // Called by the destructor if not called before.
+    void finish();
+
+private:
+    enum class Phase { Queued, Prefill, Handoff, Decode };
+
+    struct OpenSpan {
+        Phase phase = Phase::Prefill;
+        int gpu = 0;
+        int slot = -1;  // none while queued
+        int from_gpu = -1;  // source of a handoff
+        double start_ms = 0.0;
+    };
+
+    struct GpuTracks {
+        std::vector<int> free_slots;  // min-heap of released slot numbers
+        int next_slot = 0;
+        int count[4] = {0, 0, 0, 0};  // requests per Phase
+        std::uint64_t last_vram = UINT64_MAX;  // last value written to the vram counter
+    };
+
+    // Moves the request into phase on gpu, closing its previous span
+    void enter(const std::string& id, Phase phase, int gpu, double t_ms);
+    // Ends the request's open span and frees its slot; returns the slot (-1 if none)
+    int leave(const std::string& id, double t_ms);
+    void write_span(const std::string& id, const OpenSpan& span, double end_ms);
+    void write_counts(int gpu, double t_ms);
+    int acquire_slot(int gpu);
+    void release_slot(int gpu, int slot);
+    std::ostream& begin_record();
+
+    std::ostream& os_;
+    std::vector<GpuTracks> gpus_;
+    std::unordered_map<std::string, OpenSpan> open_;
+    int last_queue_depth_ = -1;
+    int last_global_depth_ = -1;
+    double last_ms_ = 0.0;
+    bool first_ = true;
+    bool finished_ = false;
+};
+
+// Whole-run forms over a finished simulator's event log and timeseries. With the flight
+// recorder on, Simulator::events() is only its window, so stream instead.
+void format_chrome_trace(std::ostream& os, const std::vector<EventRecord>& events,
+                         const std::vector<TimeseriesSample>& samples, int num_gpus);
+bool write_chrome_trace(const std::string& path, const std::vector<EventRecord>& events,
+                        const std::vector<TimeseriesSample>& samples, int num_gpus, std::string& err);
@@ -3,22 +3,62 @@
 #include <string>
 #include <deque>
 #include <list>
+#include <memory>
 #include <vector>
 #include "events.hpp"
+#include "prefill_queue.hpp"
+#include "run_arena.hpp"
 
-enum class RequestState {
+enum class RequestState : std::uint8_t {
     Arrived, 
     Queued, 
     Prefill, 
     Decode, 
     Finished, 
     Rejected, 
-    Evicted
+    Evicted,
+    Abandoned  // client timed out before the request finished
 };
 
+// Terminal states: the request holds nothing and none of its events has work left
+inline bool request_left(RequestState s) {
+    return s == RequestState::Finished || s == RequestState::Rejected || s == RequestState::Evicted ||
+           s == RequestState::Abandoned;
+}
+
 enum class SchedulingMode {
     FIFO,
-    ShortestRemaining
+    ShortestRemaining,
+    Priority,       // strict priority by request class (class 0 first), FIFO within a class
+    WeightedFair,   // self-clocked weighted fair queuing across request classes
+    PredictedShortest  // shortest prompt + predicted output first
+};
+
+enum class LengthPredictor {
+    Oracle,    // predicted = true gen_tokens
+    Noisy,     // log-normal multiplicative error
+    Bucketed   // bucket classifier with a misclassification rate
+};
+
+enum class DraftPlacement {
+    Colocated,  // draft runs on the decode GPU and its KV competes for VRAM
+    Remote      // draft runs on a separate device; adds a per-step link latency
+};
+
+enum class AcceptanceDist {
+    Fixed,
+    Uniform,
+    Beta
+};
+
+enum class GlobalDispatch {
+    FIFO,     // the oldest waiter blocks everything behind it
+    Backfill  // skip size buckets whose oldest waiter does not fit, until aging kicks in
+};
+
+enum class HandoffMode {
+    Whole,     // copy the KV in one transfer once prefill ends
+    Layerwise  // stream each layer's KV as prefill produces it
 };
 
 enum class MemoryPressurePolicy {
@@ -34,7 +74,8 @@ enum class EvictionPolicy {
 enum class RoutingPolicy {
     P2C,
     RoundRobin,
-    LeastLoaded
+    LeastLoaded,
+    SessionAffinity  // P2C, overridden by the GPU holding the session's retained KV
 };
 
 struct EventRecord {
@@ -42,6 +83,7 @@ struct EventRecord {
     EventType type = EventType::Arrival;
     std::string request_id;
     int gpu_index = 0;
+    int request_index = -1;  // trace row; not written to events.jsonl
 };
 
 struct TimeseriesSample {
@@ -57,22 +99,22 @@ struct TimeseriesSample {
     int global_queue_depth = 0;
 };
 
+// Highest request class; per-class state (WFQ tags, weights) is indexed by class
+constexpr int kMaxPriority = INT16_MAX;
+
+// One trace row. Simulation state lives in RequestTable (request_table.hpp).
 struct Request {
     std::string id;
     double arrival_time_ms = 0.0;
     int prompt_tokens = 0;
     int gen_tokens = 0;
     bool streaming = false;
-
-    RequestState state = RequestState::Arrived;
-    double start_prefill_ms = 0.0;
-    double start_decode_ms = 0.0;
-    double finish_ms = 0.0;
-
-    int prefill_gpu = 0;
-    int decode_gpu = 0;
-
-    int retry_count = 0;
+    int priority = 0;  // request class from the optional trace column; 0 = highest, at most kMaxPriority
+    std::string tenant{};  // optional trace column; empty = default tenant
+    std::string model{};   // optional trace column; empty = default model
+    std::string session{};  // optional trace column; turns of one conversation share it
+    int turn = -1;          // optional trace column; -1 = order of appearance in the session
+    double timeout_ms = 0.0;  // optional trace column; client gives up this long after arrival (0 = policy)
 };
 
 struct GPUConfig {
@@ -82,17 +124,44 @@ struct GPUConfig {
     double decode_tps = 500.0;
     int decode_sharing_cap = 8;
     double decode_efficiency = 0.8;
+    std::vector<std::string> models;  // placement: models whose weights this GPU serves (empty = all)
 };
 
 struct GPUState {
+    GPUState() : arena(std::make_unique<RunArena>()), lru_list(arena.get()), retained_sessions(arena.get()) {}
+
+    std::unique_ptr<RunArena> arena;  // backs the lists; declared first so it outlives them
     std::uint64_t vram_used = 0;
     int active_prefill = 0;
     int active_decode = 0;
-    std::deque<int> prefill_queue;
+    PrefillQueue prefill_queue;
+    std::uint64_t queued_prompt_tokens = 0;  // prompt tokens waiting in prefill_queue
     std::deque<int> evict_queue;
-    std::list<int> lru_list;
-    std::vector<std::list<int>::iterator> lru_iters;
+    std::pmr::list<int> lru_list;
+    std::vector<std::pmr::list<int>::iterator> lru_iters;
     std::vector<std::uint64_t> allocated_bytes;
+    // Sessions whose retained KV lives here, oldest first (= first to expire)
+    std::pmr::list<int> retained_sessions;
+    std::uint64_t retained_bytes = 0;  // part of vram_used
+    // Weighted fair queuing state: virtual time and last finish tag per class
+    double wfq_virtual_time = 0.0;
+    std::vector<double> wfq_last_finish;
+    // Per model: time its weights are usable on this GPU (< 0 = not resident)
+    std::vector<double> model_ready_ms;
+};
+
+struct SpecDecodeConfig {
+    bool enabled = false;
+    int draft_len = 4;                   // tokens proposed per step
+    double acceptance = 0.7;             // mean per-token acceptance rate
+    AcceptanceDist acceptance_dist = AcceptanceDist::Fixed;
+    double acceptance_spread = 0.1;      // Uniform: half-width around the mean
+    double acceptance_concentration = 20.0;  // Beta: alpha + beta
+    double draft_cost = 0.1;             // draft forward time relative to a target step
+    double verify_cost = 0.05;           // extra verify cost per drafted token at a full batch
+    std::uint64_t draft_kv_bytes_per_token = 256;
+    DraftPlacement placement = DraftPlacement::Colocated;
+    double remote_latency_ms = 0.05;     // Remote: draft/target round trip per step
 };
 
 struct PolicyConfig {
@@ -103,14 +172,100 @@ struct PolicyConfig {
     double handoff_latency_us = 10.0;       // Fixed latency overhead in microseconds
     double handoff_bandwidth_gbps = 300.0;  // Default NVLink ~300 GB/s, PCIe 4.0 ~25 GB/s
     double handoff_cost_weight = 0.5;
+    HandoffMode handoff_mode = HandoffMode::Whole;
+    int handoff_layers = 32;                // Layerwise: layers the KV is produced in
+    int handoff_chunk_layers = 1;           // Layerwise: layers per transfer; each pays handoff_latency_us
     SchedulingMode scheduling = SchedulingMode::FIFO;
     MemoryPressurePolicy memory_pressure_policy = MemoryPressurePolicy::Reject;
     EvictionPolicy eviction_policy = EvictionPolicy::FIFO;
     RoutingPolicy routing_policy = RoutingPolicy::P2C;
+    GlobalDispatch global_dispatch = GlobalDispatch::FIFO;
+    double global_aging_ms = 2000.0;  // Backfill: a waiter this old blocks backfilling (<= 0: never)
+    std::vector<double> class_weights;  // WFQ weight per request class (missing = 1.0)
+    double ttft_slo_ms = 0.0;    // default TTFT SLO for tenants without their own (0 = none)
+    bool slo_admission = false;  // reject at arrival when predicted TTFT misses the SLO
+    LengthPredictor length_predictor = LengthPredictor::Oracle;
+    double length_predictor_sigma = 0.5;  // Noisy: stddev of log error
+    int length_bucket_tokens = 128;       // Bucketed: bucket width
+    double length_bucket_error = 0.1;     // Bucketed: probability of an off-by-one bucket
+    bool predicted_reservation = false;   // reserve predicted output, grow KV on demand
+    int kv_growth_chunk_tokens = 64;      // tokens added per on-demand growth step
+    double session_kv_ttl_ms = 0.0;       // keep a finished turn's KV for the next turn (0 = off)
+    double session_affinity_weight = 1.0; // SessionAffinity: load (ms) traded per ms of prefill saved
+    SpecDecodeConfig spec_decode;
+    double request_timeout_ms = 0.0;         // client gives up on an unfinished request (0 = never)
+    std::vector<double> class_timeouts_ms;   // per request class; overrides request_timeout_ms (0 = unset)
 
     std::uint64_t vram_bytes = 24ull * 1024ull * 1024ull * 1024ull;
     double prefill_tps = 1000.0;
     double decode_tps = 500.0;
+
+    double class_weight(int cls) const {
+        if (cls >= 0 && cls < static_cast<int>(class_weights.size()) && class_weights[cls] > 0.0) {
+            return class_weights[cls];
+        }
+        return 1.0;
+    }
+
+    double timeout_for_class(int cls) const {
+        if (cls >= 0 && cls < static_cast<int>(class_timeouts_ms.size()) && class_timeouts_ms[cls] > 0.0) {
+            return class_timeouts_ms[cls];
+        }
+        return request_timeout_ms;
+    }
+};
+
+struct TenantConfig {
+    std::string name;
+    double rate_rps = 0.0;     // token-bucket refill rate in requests/sec (0 = unlimited)
+    double burst = 0.0;        // bucket capacity (0 = one second of rate, at least 1)
+    int max_inflight = 0;      // admitted but unfinished requests (0 = unlimited)
+    double ttft_slo_ms = 0.0;  // 0 = fall back to PolicyConfig::ttft_slo_ms
+};
+
+struct ModelConfig {
+    std::string name;
+    std::uint64_t weights_bytes = 0;       // VRAM held by the weights on every serving GPU
+    std::uint64_t kv_bytes_per_token = 0;  // 0 = PolicyConfig::kv_bytes_per_token
+    double prefill_speed = 1.0;            // throughput relative to the GPU's prefill_tps
+    double decode_speed = 1.0;             // throughput relative to the GPU's decode_tps
+    double swap_in_ms = 0.0;               // on-demand load time of the weights
+};
+
+enum class ModelLoading {
+    Preload,  // weights are resident on every serving GPU from t = 0
+    OnDemand  // weights load on a GPU's first admission of the model and then stay
+};
+
+struct ModelState {
+    ModelConfig cfg;              // kv_bytes_per_token resolved against the policy default
+    std::vector<char> on_gpu;     // placement flag per GPU
+    std::vector<int> gpus;        // GPUs serving the model, ascending
+    std::vector<int> nodes;       // hierarchical topology: nodes with at least one of them
+    int swap_ins = 0;
+};
+
+// KV a finished turn left behind for its conversation's next turn. At most one entry
+// per session; the next turn claims or discards it when it is placed.
+struct SessionState {
+    int gpu = -1;         // holder of the retained KV (-1 = none)
+    int model_idx = 0;
+    int tokens = 0;       // context tokens the next turn can skip
+    std::uint64_t bytes = 0;
+    double expires_ms = 0.0;
+    int owner_req = -1;   // turn that retained it; tags its expiry event
+    int latest_req = -1;  // most recently placed turn; only it may retain
+    std::pmr::list<int>::iterator pos{};  // entry in the holder's retained_sessions
+};
+
+struct TenantState {
+    TenantConfig cfg;
+    double bucket_tokens = 0.0;
+    double last_refill_ms = 0.0;
+    int inflight = 0;
+    int rate_limited = 0;
+    int quota_rejected = 0;
+    int slo_rejected = 0;
 };
 
 struct RawLink {
@@ -120,12 +275,46 @@ struct RawLink {
     double latency_ms = 0.0;
 };
 
+// Link spec shared by every GPU pair whose lowest common ancestor is one level
+struct TopologyLevel {
+    double bandwidth_gbps = 0.0;  // 0 = same as the level below
+    double latency_ms = -1.0;     // < 0 = same as the level below
+};
+
+// GPU -> node -> rack -> cluster. GPUs are numbered node by node and nodes rack by rack,
+// so a pair's path cost comes from index arithmetic instead of an all-pairs matrix.
+struct HierarchyConfig {
+    int gpus_per_node = 0;   // > 0 enables the hierarchy; 0 = flat link matrix
+    int nodes_per_rack = 0;  // 0 = a single rack
+    TopologyLevel node;      // same node (e.g. NVLink); unset = policy handoff defaults
+    TopologyLevel rack;      // different nodes in one rack
+    TopologyLevel cluster;   // different racks
+};
+
+// Flight recorder: keep only the newest `events` event records in a ring instead of the
+// whole log, and save the ring's window when a sample trips a trigger
+struct FlightRecorderConfig {
+    int events = 0;              // ring capacity (0 = off: keep the full event log)
+    int rejects_delta = 0;       // trigger: rejects in one sample (0 = off)
+    int queue_depth = 0;         // trigger: GPU-queued plus globally queued requests (0 = off)
+    double p99_ttft_ms = 0.0;    // trigger: p99 TTFT of the last p99_window first tokens (0 = off)
+    int p99_window = 200;
+    int max_dumps = 16;
+};
+
+// Fields that change a run's results must also be fed to hash_config() (result_cache.cpp)
 struct SimConfig {
     std::vector<GPUConfig> gpus;
     std::vector<std::vector<double>> latency_matrix;
     std::vector<std::vector<double>> bandwidth_matrix;
     std::vector<RawLink> raw_links;
+    HierarchyConfig hierarchy;
+    std::vector<TenantConfig> tenants;
+    std::vector<ModelConfig> models;
+    ModelLoading model_loading = ModelLoading::Preload;
     PolicyConfig policy;
     double timeseries_dt_ms = 20.0;
+    FlightRecorderConfig flight;
     unsigned int seed = 12345;
+    int replication = -1;  // >= 0: Monte Carlo replication index, selects Philox streams
 };
\ No newline at end of file
@@ -0,0 +1,644 @@
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <type_traits>
+#include "simulator.hpp"
+
+// Binary snapshot layout: header, then counters, per-request state, per-GPU
+// state, queues, RNG state and the event/sample logs, all little-endian PODs.
+namespace {
+
+constexpr char kMagic[8] = {'K', 'V', 'S', 'I', 'M', 'C', 'K', '1'};
+constexpr std::uint32_t kVersion = 9;
+
+class BinWriter {
+public:
+    explicit BinWriter(std::ostream& os) : os_(os) {}
+
+    template <typename T>
+    void put(const T& v) {
+        static_assert(std::is_trivially_copyable<T>::value, "POD only");
+        os_.write(reinterpret_cast<const char*>(&v), sizeof(T));
+    }
+    void put_str(const std::string& s) {
+        put<std::uint32_t>(static_cast<std::uint32_t>(s.size()));
+        os_.write(s.data(), static_cast<std::streamsize>(s.size()));
+    }
+    template <typename T>
+    void put_vec(const std::vector<T>& v) {
+        put<std::uint64_t>(v.size());
+        for (const auto& x : v) put(x);
+    }
+    bool ok() const { return static_cast<bool>(os_); }
+
+private:
+    std::ostream& os_;
+};
+
+class BinReader {
+public:
+    explicit BinReader(std::istream& is) : is_(is) {}
+
+    template <typename T>
+    T get() {
+        static_assert(std::is_trivially_copyable<T>::value, "POD only");
+        T v{};
+        is_.read(reinterpret_cast<char*>(&v), sizeof(T));
+        return v;
+    }
+    std::string get_str() {
+        std::uint32_t n = get<std::uint32_t>();
+        std::string s(ok() ? n : 0, '\0');
+        is_.read(&s[0], static_cast<std::streamsize>(s.size()));
+        return s;
+    }
+    template <typename T>
+    std::vector<T> get_vec() {
+        std::uint64_t n = get<std::uint64_t>();
+        std::vector<T> v;
+        for (std::uint64_t i = 0; i < n && ok(); ++i) v.push_back(get<T>());
+        return v;
+    }
+    bool ok() const { return static_cast<bool>(is_); }
+
+private:
+    std::istream& is_;
+};
+
+void put_records(BinWriter& w, const std::vector<EventRecord>& log) {
+    w.put<std::uint64_t>(log.size());
+    for (const auto& e : log) {
+        w.put(e.time_ms);
+        w.put(static_cast<std::int32_t>(e.type));
+        w.put_str(e.request_id);
+        w.put<std::int32_t>(e.gpu_index);
+        w.put<std::int32_t>(e.request_index);
+    }
+}
+
+std::vector<EventRecord> get_records(BinReader& r) {
+    std::vector<EventRecord> log;
+    std::uint64_t n = r.get<std::uint64_t>();
+    for (std::uint64_t i = 0; i < n && r.ok(); ++i) {
+        EventRecord e;
+        e.time_ms = r.get<double>();
+        e.type = static_cast<EventType>(r.get<std::int32_t>());
+        e.request_id = r.get_str();
+        e.gpu_index = r.get<std::int32_t>();
+        e.request_index = r.get<std::int32_t>();
+        log.push_back(std::move(e));
+    }
+    return log;
+}
+
+std::uint64_t trace_fingerprint(const RequestTable& reqs, const std::vector<ModelState>& models) {
+    std::uint64_t hash = 1469598103934665603ull;
+    auto mix = [&hash](const void* p, std::size_t n) {
+        const unsigned char* b = static_cast<const unsigned char*>(p);
+        for (std::size_t i = 0; i < n; ++i) {
+            hash ^= b[i];
+            hash *= 1099511628211ull;
+        }
+    };
+    for (std::size_t i = 0; i < reqs.size(); ++i) {
+        const auto& r = reqs[i];
+        const std::string& model = models[r.model_idx].cfg.name;
+        mix(reqs.id[i].data(), reqs.id[i].size());
+        mix(&reqs.arrival_ms[i], sizeof(double));
+        mix(&r.prompt_tokens, sizeof(r.prompt_tokens));
+        mix(&r.gen_tokens, sizeof(r.gen_tokens));
+        mix(model.data(), model.size());
+    }
+    return hash;
+}
+
+}  // namespace
+
+bool Simulator::save_checkpoint(std::ostream& os, std::string& err) const {
+    BinWriter w(os);
+    os.write(kMagic, sizeof(kMagic));
+    w.put(kVersion);
+    w.put<std::uint32_t>(static_cast<std::uint32_t>(gpus_.size()));
+    w.put<std::uint64_t>(requests_.size());
+    w.put(trace_fingerprint(requests_, models_));
+    w.put(static_cast<std::int32_t>(cfg_.policy.scheduling));
+
+    // Clock and counters
+    w.put<std::uint8_t>(started_ ? 1 : 0);
+    w.put(now_ms_);
+    w.put(next_sample_ms_);
+    w.put(ctr_.tokens_generated);
+    w.put(ctr_.rejects);
+    w.put(last_tokens_sampled_);
+    w.put(last_rejects_sampled_);
+    w.put(retry_attempts_);
+    w.put(retry_successes_);
+    w.put(handoffs_total_);
+    w.put(handoffs_pipelined_);
+    w.put(handoff_whole_ms_);
+    w.put(handoff_exposed_ms_);
+    w.put(ctr_.cross_gpu_decodes);
+    w.put(max_global_queue_depth_);
+    w.put(global_backfills_);
+    w.put(ctr_.kv_growth_steps);
+    w.put(ctr_.kv_growth_failures);
+    w.put(ctr_.spec_steps);
+    w.put(ctr_.spec_tokens);
+    w.put(ctr_.spec_fallbacks);
+    w.put(ctr_.session_followups);
+    w.put(ctr_.session_hits);
+    w.put(ctr_.session_reused_tokens);
+    w.put(ctr_.session_prefill_saved_ms);
+    w.put(ctr_.session_retained);
+    w.put(ctr_.session_expired);
+    w.put(ctr_.session_pressure_drops);
+    w.put(ctr_.last_request_event_ms);
+    w.put(ctr_.evictions);
+    w.put(abandoned_queued_);
+    w.put(abandoned_prefill_);
+    w.put(abandoned_decode_);
+    w.put(abandoned_prefill_ms_);
+    w.put(abandoned_decode_tokens_);
+    w.put_vec(peak_vram_per_gpu_);
+    w.put_vec(tokens_per_gpu_);
+    w.put_vec(requests_finished_per_gpu_);
+
+    // Per-request dynamic state (static trace fields come from the trace on restore)
+    for (std::size_t i = 0; i < requests_.size(); ++i) {
+        const auto& r = requests_[i];
+        const auto& spec = requests_.spec[i];
+        w.put(static_cast<std::uint8_t>(r.state));
+        w.put(requests_.start_prefill_ms[i]);
+        w.put(r.start_decode_ms);
+        w.put(requests_.finish_ms[i]);
+        w.put(r.prefill_gpu);
+        w.put(r.decode_gpu);
+        w.put<std::int32_t>(r.retry_count);
+        w.put(r.decode_end_ms);
+        w.put(r.predicted_gen_tokens);
+        w.put(spec.acceptance);
+        w.put(spec.steps);
+        w.put(spec.draft_kv_bytes);
+        w.put(r.event_generation);
+        w.put(r.pending_events);
+        w.put(r.cached_tokens);
+    }
+
+    w.put<std::uint64_t>(sessions_.size());
+    for (const auto& s : sessions_) {
+        w.put<std::int32_t>(s.gpu);
+        w.put<std::int32_t>(s.model_idx);
+        w.put<std::int32_t>(s.tokens);
+        w.put(s.bytes);
+        w.put(s.expires_ms);
+        w.put<std::int32_t>(s.owner_req);
+        w.put<std::int32_t>(s.latest_req);
+    }
+
+    for (const auto& gpu : gpus_) {
+        w.put(gpu.vram_used);
+        w.put(gpu.active_prefill);
+        w.put(gpu.active_decode);
+        w.put(gpu.wfq_virtual_time);
+        w.put_vec(gpu.wfq_last_finish);
+        w.put_vec(gpu.model_ready_ms);
+
+        // Prefill queue in dispatch order with its keys
+        PrefillQueue q = gpu.prefill_queue;
+        w.put<std::uint64_t>(q.size());
+        while (!q.empty()) {
+            w.put(q.top_key());
+            w.put<std::int32_t>(q.pop());
+        }
+        w.put<std::uint64_t>(gpu.evict_queue.size());
+        for (int idx : gpu.evict_queue) w.put<std::int32_t>(idx);
+        w.put<std::uint64_t>(gpu.lru_list.size());
+        for (int idx : gpu.lru_list) w.put<std::int32_t>(idx);
+        w.put(gpu.retained_bytes);
+        w.put<std::uint64_t>(gpu.retained_sessions.size());
+        for (int s : gpu.retained_sessions) w.put<std::int32_t>(s);
+
+        // Sparse per-request allocations
+        std::uint64_t nonzero = 0;
+        for (auto b : gpu.allocated_bytes) nonzero += (b != 0);
+        w.put(nonzero);
+        for (std::size_t i = 0; i < gpu.allocated_bytes.size(); ++i) {
+            if (gpu.allocated_bytes[i] == 0) continue;
+            w.put<std::int32_t>(static_cast<std::int32_t>(i));
+            w.put(gpu.allocated_bytes[i]);
+        }
+    }
+
+    w.put<std::uint64_t>(global_queue_.size());
+    for (const auto& e : global_queue_.entries()) {
+        w.put<std::int32_t>(e.req_idx);
+        w.put(e.enqueued_ms);
+    }
+
+    // Armed client timeouts; the wake-up events are in the heap
+    w.put(timers_.tick_ms());
+    w.put(timers_.cursor());
+    w.put(next_tick_ms_);
+    const auto timers = timers_.entries();
+    w.put<std::uint64_t>(timers.size());
+    for (const auto& t : timers) {
+        w.put(t.deadline_ms);
+        w.put<std::int32_t>(t.req_idx);
+    }
+
+    w.put<std::uint64_t>(tenants_.size());
+    for (const auto& t : tenants_) {
+        w.put_str(t.cfg.name);
+        w.put(t.bucket_tokens);
+        w.put(t.last_refill_ms);
+        w.put(t.inflight);
+        w.put(t.rate_limited);
+        w.put(t.quota_rejected);
+        w.put(t.slo_rejected);
+    }
+
+    w.put<std::uint64_t>(models_.size());
+    for (const auto& m : models_) {
+        w.put_str(m.cfg.name);
+        w.put(m.swap_ins);
+    }
+
+    w.put_str(rng_.state());
+
+    // Raw heap storage keeps equal-time events in exactly the same pop order
+    const auto& heap = pq_.heap();
+    w.put<std::uint64_t>(heap.size());
+    for (const auto& e : heap) {
+        w.put(e.time_ms);
+        w.put(static_cast<std::int32_t>(e.type));
+        w.put<std::int32_t>(e.request_index);
+        w.put<std::int32_t>(e.gpu_index);
+        w.put(e.generation);
+    }
+    w.put(dead_events_);
+
+    // The flight recorder's window stands in for the log when it is on
+    put_records(w, events());
+    w.put(flight_.recorded_);
+    w.put(flight_.last_dump_at_);
+    w.put<std::uint64_t>(flight_.ttfts_.size());
+    for (std::size_t i = 0; i < flight_.ttfts_.size(); ++i) {
+        w.put(flight_.ttfts_[(flight_.ttft_head_ + i) % flight_.ttfts_.size()]);
+    }
+    w.put<std::uint64_t>(flight_.dumps_.size());
+    for (const auto& d : flight_.dumps_) {
+        w.put(d.time_ms);
+        w.put_str(d.reason);
+        w.put<std::uint64_t>(d.num_events);
+        w.put<std::uint8_t>(d.written);
+        put_records(w, d.events);
+    }
+
+    w.put<std::uint64_t>(samples_.size());
+    for (const auto& s : samples_) {
+        w.put(s.time_ms);
+        w.put(s.vram_used);
+        w.put(s.active_prefill);
+        w.put(s.active_decode);
+        w.put(s.queue_depth);
+        w.put(s.tokens_generated_delta);
+        w.put(s.rejects_delta);
+        w.put(s.global_queue_depth);
+        w.put_vec(s.vram_per_gpu);
+    }
+
+    if (!w.ok()) {
+        err = "checkpoint write failed";
+        return false;
+    }
+    return true;
+}
+
+bool Simulator::load_checkpoint(std::istream& is, std::string& err) {
+    BinReader r(is);
+    char magic[sizeof(kMagic)] = {};
+    is.read(magic, sizeof(magic));
+    if (!r.ok() || std::memcmp(magic, kMagic, sizeof(kMagic)) != 0) {
+        err = "not a kv_sim checkpoint";
+        return false;
+    }
+    if (r.get<std::uint32_t>() != kVersion) {
+        err = "unsupported checkpoint version";
+        return false;
+    }
+    if (r.get<std::uint32_t>() != gpus_.size()) {
+        err = "checkpoint GPU count does not match config";
+        return false;
+    }
+    if (r.get<std::uint64_t>() != requests_.size() || r.get<std::uint64_t>() != trace_fingerprint(requests_, models_)) {
+        err = "checkpoint was taken with a different trace";
+        return false;
+    }
+    auto saved_scheduling = static_cast<SchedulingMode>(r.get<std::int32_t>());
+
+    started_ = r.get<std::uint8_t>() != 0;
+    now_ms_ = r.get<double>();
+    next_sample_ms_ = r.get<double>();
+    ctr_.tokens_generated = r.get<std::uint64_t>();
+    ctr_.rejects = r.get<int>();
+    last_tokens_sampled_ = r.get<std::uint64_t>();
+    last_rejects_sampled_ = r.get<int>();
+    retry_attempts_ = r.get<int>();
+    retry_successes_ = r.get<int>();
+    handoffs_total_ = r.get<int>();
+    handoffs_pipelined_ = r.get<int>();
+    handoff_whole_ms_ = r.get<double>();
+    handoff_exposed_ms_ = r.get<double>();
+    ctr_.cross_gpu_decodes = r.get<int>();
+    max_global_queue_depth_ = r.get<int>();
+    global_backfills_ = r.get<int>();
+    ctr_.kv_growth_steps = r.get<int>();
+    ctr_.kv_growth_failures = r.get<int>();
+    ctr_.spec_steps = r.get<double>();
+    ctr_.spec_tokens = r.get<std::uint64_t>();
+    ctr_.spec_fallbacks = r.get<int>();
+    ctr_.session_followups = r.get<int>();
+    ctr_.session_hits = r.get<int>();
+    ctr_.session_reused_tokens = r.get<std::uint64_t>();
+    ctr_.session_prefill_saved_ms = r.get<double>();
+    ctr_.session_retained = r.get<int>();
+    ctr_.session_expired = r.get<int>();
+    ctr_.session_pressure_drops = r.get<int>();
+    ctr_.last_request_event_ms = r.get<double>();
+    ctr_.evictions = r.get<int>();
+    abandoned_queued_ = r.get<int>();
+    abandoned_prefill_ = r.get<int>();
+    abandoned_decode_ = r.get<int>();
+    abandoned_prefill_ms_ = r.get<double>();
+    abandoned_decode_tokens_ = r.get<double>();
+    peak_vram_per_gpu_ = r.get_vec<std::uint64_t>();
+    tokens_per_gpu_ = r.get_vec<std::uint64_t>();
+    requests_finished_per_gpu_ = r.get_vec<int>();
+
+    for (std::size_t i = 0; i < requests_.size(); ++i) {
+        auto& req = requests_[i];
+        auto& spec = requests_.spec[i];
+        req.state = static_cast<RequestState>(r.get<std::uint8_t>());
+        requests_.start_prefill_ms[i] = r.get<double>();
+        req.start_decode_ms = r.get<double>();
+        requests_.finish_ms[i] = r.get<double>();
+        req.prefill_gpu = r.get<int>();
+        req.decode_gpu = r.get<int>();
+        req.retry_count = static_cast<std::int16_t>(r.get<std::int32_t>());
+        req.decode_end_ms = r.get<double>();
+        req.predicted_gen_tokens = r.get<int>();
+        spec.acceptance = r.get<double>();
+        spec.steps = r.get<double>();
+        spec.draft_kv_bytes = r.get<std::uint64_t>();
+        req.event_generation = r.get<std::uint32_t>();
+        req.pending_events = r.get<int>();
+        req.cached_tokens = r.get<std::int32_t>();
+    }
+
+    if (r.get<std::uint64_t>() != sessions_.size()) {
+        err = "checkpoint was taken with a different trace";
+        return false;
+    }
+    for (auto& s : sessions_) {
+        s.gpu = r.get<std::int32_t>();
+        s.model_idx = r.get<std::int32_t>();
+        s.tokens = r.get<std::int32_t>();
+        s.bytes = r.get<std::uint64_t>();
+        s.expires_ms = r.get<double>();
+        s.owner_req = r.get<std::int32_t>();
+        s.latest_req = r.get<std::int32_t>();
+    }
+
+    for (std::size_t g = 0; g < gpus_.size(); ++g) {
+        auto& gpu = gpus_[g];
+        gpu.vram_used = r.get<std::uint64_t>();
+        gpu.active_prefill = r.get<int>();
+        gpu.active_decode = r.get<int>();
+        gpu.wfq_virtual_time = r.get<double>();
+        gpu.wfq_last_finish = r.get_vec<double>();
+        gpu.model_ready_ms = r.get_vec<double>();
+        if (gpu.model_ready_ms.size() != models_.size()) {
+            err = "checkpoint model set does not match config";
+            return false;
+        }
+
+        gpu.prefill_queue.reset(requests_.size());
+        gpu.queued_prompt_tokens = 0;
+        std::uint64_t queued = r.get<std::uint64_t>();
+        for (std::uint64_t i = 0; i < queued && r.ok(); ++i) {
+            double key = r.get<double>();
+            int idx = r.get<std::int32_t>();
+            if (idx < 0 || idx >= static_cast<int>(requests_.size())) {
+                err = "corrupt checkpoint (prefill queue)";
+                return false;
+            }
+            // A what-if with a different scheduler re-keys the queue under the new policy
+            if (saved_scheduling == cfg_.policy.scheduling) {
+                gpu.prefill_queue.push(idx, key);
+                gpu.queued_prompt_tokens += static_cast<std::uint64_t>(requests_[idx].prompt_tokens);
+            } else {
+                enqueue_prefill(idx, static_cast<int>(g));
+            }
+        }
+
+        gpu.evict_queue.clear();
+        std::uint64_t n_evict = r.get<std::uint64_t>();
+        for (std::uint64_t i = 0; i < n_evict && r.ok(); ++i) gpu.evict_queue.push_back(r.get<std::int32_t>());
+
+        gpu.lru_list.clear();
+        gpu.lru_iters.assign(requests_.size(), gpu.lru_list.end());
+        std::uint64_t n_lru = r.get<std::uint64_t>();
+        for (std::uint64_t i = 0; i < n_lru && r.ok(); ++i) {
+            int idx = r.get<std::int32_t>();
+            if (idx < 0 || idx >= static_cast<int>(requests_.size())) {
+                err = "corrupt checkpoint (lru list)";
+                return false;
+            }
+            gpu.lru_list.push_back(idx);
+            gpu.lru_iters[idx] = std::prev(gpu.lru_list.end());
+        }
+
+        gpu.retained_bytes = r.get<std::uint64_t>();
+        gpu.retained_sessions.clear();
+        std::uint64_t n_retained = r.get<std::uint64_t>();
+        for (std::uint64_t i = 0; i < n_retained && r.ok(); ++i) {
+            int s = r.get<std::int32_t>();
+            if (s < 0 || s >= static_cast<int>(sessions_.size()) || sessions_[s].gpu != static_cast<int>(g)) {
+                err = "corrupt checkpoint (retained sessions)";
+                return false;
+            }
+            sessions_[s].pos = gpu.retained_sessions.insert(gpu.retained_sessions.end(), s);
+        }
+
+        gpu.allocated_bytes.assign(requests_.size(), 0);
+        std::uint64_t n_alloc = r.get<std::uint64_t>();
+        for (std::uint64_t i = 0; i < n_alloc && r.ok(); ++i) {
+            int idx = r.get<std::int32_t>();
+            std::uint64_t bytes = r.get<std::uint64_t>();
+            if (idx < 0 || idx >= static_cast<int>(requests_.size())) {
+                err = "corrupt checkpoint (allocations)";
+                return false;
+            }
+            gpu.allocated_bytes[idx] = bytes;
+        }
+    }
+
+    global_queue_.clear();
+    std::uint64_t n_global = r.get<std::uint64_t>();
+    for (std::uint64_t i = 0; i < n_global && r.ok(); ++i) {
+        int idx = r.get<std::int32_t>();
+        double enqueued_ms = r.get<double>();
+        if (idx < 0 || idx >= static_cast<int>(requests_.size())) {
+            err = "corrupt checkpoint (global queue)";
+            return false;
+        }
+        // Re-bucketed under the current dispatch policy; age order is kept
+        enqueue_global(idx, enqueued_ms);
+    }
+
+    // Same wheel geometry resumes exactly; a what-if with other timeouts re-buckets the
+    // deadlines already armed (dropping them when timeouts are now off)
+    double saved_tick = r.get<double>();
+    std::int64_t saved_cursor = r.get<std::int64_t>();
+    double saved_next_tick = r.get<double>();
+    std::uint64_t n_timers = r.get<std::uint64_t>();
+    std::vector<TimerWheel::Entry> timers;
+    for (std::uint64_t i = 0; i < n_timers && r.ok(); ++i) {
+        TimerWheel::Entry t;
+        t.deadline_ms = r.get<double>();
+        t.req_idx = r.get<std::int32_t>();
+        if (t.req_idx < 0 || t.req_idx >= static_cast<int>(requests_.size())) {
+            err = "corrupt checkpoint (timeouts)";
+            return false;
+        }
+        timers.push_back(t);
+    }
+
+    std::uint64_t n_tenants = r.get<std::uint64_t>();
+    if (n_tenants != tenants_.size()) {
+        err = "checkpoint tenant set does not match config";
+        return false;
+    }
+    for (auto& t : tenants_) {
+        if (r.get_str() != t.cfg.name) {
+            err = "checkpoint tenant set does not match config";
+            return false;
+        }
+        t.bucket_tokens = r.get<double>();
+        t.last_refill_ms = r.get<double>();
+        t.inflight = r.get<int>();
+        t.rate_limited = r.get<int>();
+        t.quota_rejected = r.get<int>();
+        t.slo_rejected = r.get<int>();
+    }
+
+    std::uint64_t n_models = r.get<std::uint64_t>();
+    if (n_models != models_.size()) {
+        err = "checkpoint model set does not match config";
+        return false;
+    }
+    for (auto& m : models_) {
+        if (r.get_str() != m.cfg.name) {
+            err = "checkpoint model set does not match config";
+            return false;
+        }
+        m.swap_ins = r.get<int>();
+    }
+
+    if (!rng_.set_state(r.get_str())) {
+        err = "corrupt checkpoint (rng state)";
+        return false;
+    }
+
+    std::vector<Event> heap;
+    std::uint64_t n_heap = r.get<std::uint64_t>();
+    heap.reserve(n_heap);
+    for (std::uint64_t i = 0; i < n_heap && r.ok(); ++i) {
+        Event e;
+        e.time_ms = r.get<double>();
+        e.type = static_cast<EventType>(r.get<std::int32_t>());
+        e.request_index = r.get<std::int32_t>();
+        e.gpu_index = r.get<std::int32_t>();
+        e.generation = r.get<std::uint32_t>();
+        heap.push_back(e);
+    }
+    pq_.assign_heap(std::move(heap));
+    dead_events_ = r.get<std::int64_t>();
+
+    timers_.reset(timers_.tick_ms());
+    next_tick_ms_ = std::numeric_limits<double>::infinity();
+    if (timers_.enabled()) {
+        if (saved_tick == timers_.tick_ms()) {
+            timers_.set_cursor(saved_cursor);
+            next_tick_ms_ = saved_next_tick;
+        }
+        for (const auto& t : timers) arm_deadline(t.req_idx, t.deadline_ms);
+    }
+
+    // Either log form restores into either mode; a smaller ring keeps the newest records
+    events_ = get_records(r);
+    flight_.reset(cfg_.flight);
+    if (flight_.enabled()) {
+        for (auto& e : events_) flight_.record(std::move(e));
+        events_.clear();
+    }
+    std::uint64_t recorded = r.get<std::uint64_t>();
+    std::uint64_t last_dump_at = r.get<std::uint64_t>();
+    std::uint64_t n_ttfts = r.get<std::uint64_t>();
+    for (std::uint64_t i = 0; i < n_ttfts && r.ok(); ++i) flight_.note_ttft(r.get<double>());
+    std::uint64_t n_dumps = r.get<std::uint64_t>();
+    for (std::uint64_t i = 0; i < n_dumps && r.ok(); ++i) {
+        FlightRecorder::Dump d;
+        d.time_ms = r.get<double>();
+        d.reason = r.get_str();
+        d.num_events = r.get<std::uint64_t>();
+        d.written = r.get<std::uint8_t>() != 0;
+        d.events = get_records(r);
+        flight_.dumps_.push_back(std::move(d));
+    }
+    if (flight_.enabled()) {
+        flight_.recorded_ = std::max(flight_.recorded_, recorded);
+        flight_.last_dump_at_ = last_dump_at;
+    }
+
+    samples_.clear();
+    std::uint64_t n_samples = r.get<std::uint64_t>();
+    for (std::uint64_t i = 0; i < n_samples && r.ok(); ++i) {
+        TimeseriesSample s;
+        s.time_ms = r.get<double>();
+        s.vram_used = r.get<std::uint64_t>();
+        s.active_prefill = r.get<int>();
+        s.active_decode = r.get<int>();
+        s.queue_depth = r.get<int>();
+        s.tokens_generated_delta = r.get<std::uint64_t>();
+        s.rejects_delta = r.get<int>();
+        s.global_queue_depth = r.get<int>();
+        s.vram_per_gpu = r.get_vec<std::uint64_t>();
+        samples_.push_back(std::move(s));
+    }
+
+    if (!r.ok()) {
+        err = "truncated checkpoint";
+        return false;
+    }
+    return true;
+}
+
+bool Simulator::save_checkpoint(const std::string& path, std::string& err) const {
+    std::ofstream ofs(path, std::ios::binary);
+    if (!ofs.is_open()) {
+        err = "cannot open checkpoint for writing: " + path;
+        return false;
+    }
+    return save_checkpoint(static_cast<std::ostream&>(ofs), err);
+}
+
+bool Simulator::load_checkpoint(const std::string& path, std::string& err) {
+    std::ifstream ifs(path, std::ios::binary);
+    if (!ifs.is_open()) {
+        err = "checkpoint not found: " + path;
+        return false;
+    }
+    return load_checkpoint(static_cast<std::istream&>(ifs), err);
+}
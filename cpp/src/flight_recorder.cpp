@@ -0,0 +1,123 @@
+#include "flight_recorder.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include "io_output.hpp"
+
+void FlightRecorder::reset(const FlightRecorderConfig& cfg) {
+    cfg_ = cfg;
+    ring_.clear();
+    if (enabled()) ring_.reserve(static_cast<std::size_t>(cfg_.events));
+    head_ = 0;
+    recorded_ = 0;
+    last_dump_at_ = 0;
+    ttfts_.clear();
+    ttft_head_ = 0;
+    ttft_changed_ = false;
+    ttft_p99_ = 0.0;
+    dumps_.clear();
+    window_.clear();
+    window_at_ = UINT64_MAX;
+}
+
+void FlightRecorder::record(EventRecord r) {
+    if (ring_.size() < static_cast<std::size_t>(cfg_.events)) {
+        ring_.push_back(std::move(r));
+    } else {
+        ring_[head_] = std::move(r);
+        head_ = (head_ + 1) % ring_.size();
+    }
+    ++recorded_;
+}
+
+void FlightRecorder::note_ttft(double ttft_ms) {
+    if (cfg_.p99_ttft_ms <= 0.0) return;
+    if (ttfts_.size() < static_cast<std::size_t>(cfg_.p99_window)) {
+        ttfts_.push_back(ttft_ms);
+    } else {
+        ttfts_[ttft_head_] = ttft_ms;
+        ttft_head_ = (ttft_head_ + 1) % ttfts_.size();
+    }
+    ttft_changed_ = true;
+}
+
+double FlightRecorder::ttft_p99() {
+    if (ttft_changed_) {
+        // Same rank as the summary percentiles
+        scratch_.assign(ttfts_.begin(), ttfts_.end());
+        auto nth = scratch_.begin() + static_cast<std::ptrdiff_t>(0.99 * static_cast<double>(scratch_.size() - 1));
+        std::nth_element(scratch_.begin(), nth, scratch_.end());
+        ttft_p99_ = *nth;
+        ttft_changed_ = false;
+    }
+    return ttft_p99_;
+}
+
+void FlightRecorder::check(const TimeseriesSample& s) {
+    if (recorded_ == 0 || dumps_.size() >= static_cast<std::size_t>(cfg_.max_dumps)) return;
+    if (!dumps_.empty() && recorded_ - last_dump_at_ < static_cast<std::uint64_t>(cfg_.events)) return;
+
+    char reason[64] = "";
+    int queued = s.queue_depth + s.global_queue_depth;
+    if (cfg_.rejects_delta > 0 && s.rejects_delta >= cfg_.rejects_delta) {
+        std::snprintf(reason, sizeof(reason), "rejects_delta %d", s.rejects_delta);
+    } else if (cfg_.queue_depth > 0 && queued >= cfg_.queue_depth) {
+        std::snprintf(reason, sizeof(reason), "queue_depth %d", queued);
+    } else if (cfg_.p99_ttft_ms > 0.0 && ttfts_.size() == static_cast<std::size_t>(cfg_.p99_window) &&
+               ttft_p99() >= cfg_.p99_ttft_ms) {
+        std::snprintf(reason, sizeof(reason), "p99_ttft_ms %.3f", ttft_p99_);
+    }
+    if (reason[0] == '\0') return;
+
+    Dump d;
+    d.time_ms = s.time_ms;
+    d.reason = reason;
+    d.events = window();
+    d.num_events = d.events.size();
+    std::string err;
+    if (!dir_.empty() && write_dump(dir_, dumps_.size(), d.events, err)) {
+        d.written = true;
+        std::vector<EventRecord>().swap(d.events);
+    }
+    dumps_.push_back(std::move(d));
+    last_dump_at_ = recorded_;
+}
+
+const std::vector<EventRecord>& FlightRecorder::window() const {
+    if (window_at_ != recorded_) {
+        window_.clear();
+        window_.reserve(ring_.size());
+        window_.insert(window_.end(), ring_.begin() + static_cast<std::ptrdiff_t>(head_), ring_.end());
+        window_.insert(window_.end(), ring_.begin(), ring_.begin() + static_cast<std::ptrdiff_t>(head_));
+        window_at_ = recorded_;
+    }
+    return window_;
+}
+
+std::string FlightRecorder::dump_file_name(std::size_t k) {
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "flight_%03zu.jsonl", k);
+    return buf;
+}
+
+bool FlightRecorder::write_dump(const std::string& dir, std::size_t k, const std::vector<EventRecord>& events,
+                                std::string& err) const {
+    std::error_code ec;
+    std::filesystem::create_directories(dir, ec);
+    std::string path = dir + "/" + dump_file_name(k);
+    std::ofstream ofs(path);
+    if (!ofs.is_open()) {
+        err = "cannot open " + path;
+        return false;
+    }
+    format_events_jsonl(ofs, events);
+    return true;
+}
+
+bool FlightRecorder::write_held_dumps(const std::string& dir, std::string& err) const {
+    for (std::size_t k = 0; k < dumps_.size(); ++k) {
+        if (!dumps_[k].written && !write_dump(dir, k, dumps_[k].events, err)) return false;
+    }
+    return true;
+}
@@ -3,17 +3,39 @@
 #include <sstream>
 #include <algorithm>
 
-bool load_config(const std::string& path, SimConfig& cfg, std::string& err) {
-    if (cfg.gpus.empty()) {
-        cfg.gpus.push_back(GPUConfig{});
+namespace {
+
+std::vector<std::string> split_list(const std::string& s) {
+    std::vector<std::string> out;
+    std::istringstream iss(s);
+    std::string item;
+    while (std::getline(iss, item, ',')) {
+        if (!item.empty()) out.push_back(item);
     }
-    int num_gpus_requested = static_cast<int>(cfg.gpus.size());
+    return out;
+}
+
+}  // namespace
 
+bool load_config(const std::string& path, SimConfig& cfg, std::string& err) {
     std::ifstream f(path);
     if (!f.is_open()) {
+        if (cfg.gpus.empty()) {
+            cfg.gpus.push_back(GPUConfig{});
+        }
         err = "config file not found, using defaults";
         return true;
     }
+    return load_config_stream(f, cfg, err);
+}
+
+bool load_config_stream(std::istream& f, SimConfig& cfg, std::string& err) {
+    (void)err;  // malformed lines are skipped, keeping defaults
+    if (cfg.gpus.empty()) {
+        cfg.gpus.push_back(GPUConfig{});
+    }
+    int num_gpus_requested = static_cast<int>(cfg.gpus.size());
+
     std::string line;
     while (std::getline(f, line)) {
         if (line.empty() || line[0] == '#') continue;
@@ -38,11 +60,138 @@ bool load_config(const std::string& path, SimConfig& cfg, std::string& err) {
         else if (key == "max_retries" && (iss >> ival)) cfg.policy.max_admission_retries = ival;
         else if (key == "safe_reservation" && (iss >> ival)) cfg.policy.safe_reservation = (ival != 0);
         else if (key == "timeseries_dt_ms" && (iss >> dval)) cfg.timeseries_dt_ms = dval;
+        else if (key == "flight_recorder" && (iss >> ival) && ival >= 0) cfg.flight.events = ival;
+        else if (key == "flight_rejects_delta" && (iss >> ival)) cfg.flight.rejects_delta = ival;
+        else if (key == "flight_queue_depth" && (iss >> ival)) cfg.flight.queue_depth = ival;
+        else if (key == "flight_p99_ttft_ms" && (iss >> dval)) cfg.flight.p99_ttft_ms = dval;
+        else if (key == "flight_p99_window" && (iss >> ival) && ival > 0) cfg.flight.p99_window = ival;
+        else if (key == "flight_max_dumps" && (iss >> ival) && ival >= 0) cfg.flight.max_dumps = ival;
         else if (key == "scheduling" && (iss >> sval)) {
             sval = to_lower(sval);
             if (sval == "fifo") cfg.policy.scheduling = SchedulingMode::FIFO;
             else if (sval == "shortest" || sval == "srt" || sval == "shortest_remaining")
                 cfg.policy.scheduling = SchedulingMode::ShortestRemaining;
+            else if (sval == "priority" || sval == "strict_priority")
+                cfg.policy.scheduling = SchedulingMode::Priority;
+            else if (sval == "wfq" || sval == "fair" || sval == "weighted_fair")
+                cfg.policy.scheduling = SchedulingMode::WeightedFair;
+            else if (sval == "predicted_srt" || sval == "predicted_shortest")
+                cfg.policy.scheduling = SchedulingMode::PredictedShortest;
+        }
+        else if (key == "length_predictor" && (iss >> sval)) {
+            sval = to_lower(sval);
+            if (sval == "oracle") cfg.policy.length_predictor = LengthPredictor::Oracle;
+            else if (sval == "noisy" || sval == "lognormal") cfg.policy.length_predictor = LengthPredictor::Noisy;
+            else if (sval == "bucketed" || sval == "bucket") cfg.policy.length_predictor = LengthPredictor::Bucketed;
+        }
+        else if (key == "length_predictor_sigma" && (iss >> dval)) cfg.policy.length_predictor_sigma = dval;
+        else if (key == "length_bucket_tokens" && (iss >> ival)) cfg.policy.length_bucket_tokens = ival;
+        else if (key == "length_bucket_error" && (iss >> dval)) cfg.policy.length_bucket_error = dval;
+        else if (key == "predicted_reservation" && (iss >> ival)) cfg.policy.predicted_reservation = (ival != 0);
+        else if (key == "kv_growth_chunk_tokens" && (iss >> ival)) cfg.policy.kv_growth_chunk_tokens = ival;
+        else if (key == "session_kv_ttl_ms" && (iss >> dval)) cfg.policy.session_kv_ttl_ms = dval;
+        else if (key == "session_affinity_weight" && (iss >> dval)) cfg.policy.session_affinity_weight = dval;
+        else if (key == "spec_decode" && (iss >> ival)) cfg.policy.spec_decode.enabled = (ival != 0);
+        else if (key == "spec_draft_len" && (iss >> ival)) cfg.policy.spec_decode.draft_len = ival;
+        else if (key == "spec_acceptance" && (iss >> dval)) cfg.policy.spec_decode.acceptance = dval;
+        else if (key == "spec_acceptance_dist" && (iss >> sval)) {
+            sval = to_lower(sval);
+            if (sval == "fixed") cfg.policy.spec_decode.acceptance_dist = AcceptanceDist::Fixed;
+            else if (sval == "uniform") cfg.policy.spec_decode.acceptance_dist = AcceptanceDist::Uniform;
+            else if (sval == "beta") cfg.policy.spec_decode.acceptance_dist = AcceptanceDist::Beta;
+        }
+        else if (key == "spec_acceptance_spread" && (iss >> dval)) cfg.policy.spec_decode.acceptance_spread = dval;
+        else if (key == "spec_acceptance_concentration" && (iss >> dval)) cfg.policy.spec_decode.acceptance_concentration = dval;
+        else if (key == "spec_draft_cost" && (iss >> dval)) cfg.policy.spec_decode.draft_cost = dval;
+        else if (key == "spec_verify_cost" && (iss >> dval)) cfg.policy.spec_decode.verify_cost = dval;
+        else if (key == "spec_draft_kv_bytes_per_token" && (iss >> uval)) cfg.policy.spec_decode.draft_kv_bytes_per_token = uval;
+        else if (key == "spec_draft_placement" && (iss >> sval)) {
+            sval = to_lower(sval);
+            if (sval == "colocated" || sval == "local") cfg.policy.spec_decode.placement = DraftPlacement::Colocated;
+            else if (sval == "remote" || sval == "separate") cfg.policy.spec_decode.placement = DraftPlacement::Remote;
+        }
+        else if (key == "spec_remote_latency_ms" && (iss >> dval)) cfg.policy.spec_decode.remote_latency_ms = dval;
+        else if (key == "class_weight") {
+            // Format: class_weight <class> <weight>
+            int cls = -1;
+            if ((iss >> cls >> dval) && cls >= 0 && cls <= kMaxPriority && dval > 0.0) {
+                if (cls >= static_cast<int>(cfg.policy.class_weights.size())) {
+                    cfg.policy.class_weights.resize(cls + 1, 1.0);
+                }
+                cfg.policy.class_weights[cls] = dval;
+            }
+        }
+        else if (key == "request_timeout_ms" && (iss >> dval) && dval >= 0.0) cfg.policy.request_timeout_ms = dval;
+        else if (key == "class_timeout") {
+            // Format: class_timeout <class> <ms>
+            int cls = -1;
+            if ((iss >> cls >> dval) && cls >= 0 && cls <= kMaxPriority && dval >= 0.0) {
+                if (cls >= static_cast<int>(cfg.policy.class_timeouts_ms.size())) {
+                    cfg.policy.class_timeouts_ms.resize(cls + 1, 0.0);
+                }
+                cfg.policy.class_timeouts_ms[cls] = dval;
+            }
+        }
+        else if (key == "ttft_slo_ms" && (iss >> dval)) cfg.policy.ttft_slo_ms = dval;
+        else if (key == "slo_admission" && (iss >> ival)) cfg.policy.slo_admission = (ival != 0);
+        else if (key == "tenant") {
+            // Format: tenant <name> [rate_rps <val>] [burst <val>] [max_inflight <n>] [ttft_slo_ms <val>]
+            std::string name;
+            if (!(iss >> name)) continue;
+            auto it = std::find_if(cfg.tenants.begin(), cfg.tenants.end(),
+                                   [&](const TenantConfig& t) { return t.name == name; });
+            if (it == cfg.tenants.end()) {
+                cfg.tenants.push_back(TenantConfig{});
+                cfg.tenants.back().name = name;
+                it = std::prev(cfg.tenants.end());
+            }
+            std::string subkey;
+            while (iss >> subkey) {
+                subkey = to_lower(subkey);
+                if (subkey == "rate_rps" && (iss >> dval)) {
+                    it->rate_rps = dval;
+                } else if (subkey == "burst" && (iss >> dval)) {
+                    it->burst = dval;
+                } else if (subkey == "max_inflight" && (iss >> ival)) {
+                    it->max_inflight = ival;
+                } else if (subkey == "ttft_slo_ms" && (iss >> dval)) {
+                    it->ttft_slo_ms = dval;
+                }
+            }
+        }
+        else if (key == "model") {
+            // Format: model <name> [weights_bytes <n>] [kv_bytes_per_token <n>] [prefill_speed <val>]
+            //                      [decode_speed <val>] [swap_in_ms <val>]
+            std::string name;
+            if (!(iss >> name)) continue;
+            auto it = std::find_if(cfg.models.begin(), cfg.models.end(),
+                                   [&](const ModelConfig& m) { return m.name == name; });
+            if (it == cfg.models.end()) {
+                cfg.models.push_back(ModelConfig{});
+                cfg.models.back().name = name;
+                it = std::prev(cfg.models.end());
+            }
+            std::string subkey;
+            while (iss >> subkey) {
+                subkey = to_lower(subkey);
+                if (subkey == "weights_bytes" && (iss >> uval)) {
+                    it->weights_bytes = uval;
+                } else if (subkey == "kv_bytes_per_token" && (iss >> uval)) {
+                    it->kv_bytes_per_token = uval;
+                } else if (subkey == "prefill_speed" && (iss >> dval) && dval > 0.0) {
+                    it->prefill_speed = dval;
+                } else if (subkey == "decode_speed" && (iss >> dval) && dval > 0.0) {
+                    it->decode_speed = dval;
+                } else if (subkey == "swap_in_ms" && (iss >> dval) && dval >= 0.0) {
+                    it->swap_in_ms = dval;
+                }
+            }
+        }
+        else if (key == "models" && (iss >> sval)) cfg.gpus[0].models = split_list(sval);
+        else if (key == "model_loading" && (iss >> sval)) {
+            sval = to_lower(sval);
+            if (sval == "preload") cfg.model_loading = ModelLoading::Preload;
+            else if (sval == "on_demand" || sval == "ondemand") cfg.model_loading = ModelLoading::OnDemand;
         }
         else if (key == "handoff_latency_us" && (iss >> dval)) {
             cfg.policy.handoff_latency_us = dval;
@@ -53,6 +202,19 @@ bool load_config(const std::string& path, SimConfig& cfg, std::string& err) {
         else if (key == "handoff_cost_weight" && (iss >> dval)) {
             cfg.policy.handoff_cost_weight = dval;
         }
+        else if (key == "handoff_mode" && (iss >> sval)) {
+            sval = to_lower(sval);
+            if (sval == "whole" || sval == "bulk") cfg.policy.handoff_mode = HandoffMode::Whole;
+            else if (sval == "layerwise" || sval == "pipelined") cfg.policy.handoff_mode = HandoffMode::Layerwise;
+        }
+        else if (key == "handoff_layers" && (iss >> ival) && ival > 0) cfg.policy.handoff_layers = ival;
+        else if (key == "handoff_chunk_layers" && (iss >> ival) && ival > 0) cfg.policy.handoff_chunk_layers = ival;
+        else if (key == "global_dispatch" && (iss >> sval)) {
+            sval = to_lower(sval);
+            if (sval == "fifo") cfg.policy.global_dispatch = GlobalDispatch::FIFO;
+            else if (sval == "backfill") cfg.policy.global_dispatch = GlobalDispatch::Backfill;
+        }
+        else if (key == "global_aging_ms" && (iss >> dval)) cfg.policy.global_aging_ms = dval;
         else if (key == "routing_policy" && (iss >> sval)) {
             sval = to_lower(sval);
             if (sval == "p2c" || sval == "power2choices" || sval == "power_of_two_choices") {
@@ -61,6 +223,8 @@ bool load_config(const std::string& path, SimConfig& cfg, std::string& err) {
                 cfg.policy.routing_policy = RoutingPolicy::RoundRobin;
             } else if (sval == "leastloaded" || sval == "least" || sval == "ll") {
                 cfg.policy.routing_policy = RoutingPolicy::LeastLoaded;
+            } else if (sval == "affinity" || sval == "session_affinity") {
+                cfg.policy.routing_policy = RoutingPolicy::SessionAffinity;
             }
         }
         else if (key == "link") {
@@ -71,6 +235,17 @@ bool load_config(const std::string& path, SimConfig& cfg, std::string& err) {
                 cfg.raw_links.push_back(RawLink{src, dest, bw, lat});
             }
         }
+        else if (key == "gpus_per_node" && (iss >> ival) && ival >= 0) cfg.hierarchy.gpus_per_node = ival;
+        else if (key == "nodes_per_rack" && (iss >> ival) && ival >= 0) cfg.hierarchy.nodes_per_rack = ival;
+        else if (key == "topology_level" && (iss >> sval)) {
+            // Expected format: topology_level <node|rack|cluster> <bandwidth_gbps> <latency_ms>
+            double bw = 0.0, lat = 0.0;
+            sval = to_lower(sval);
+            TopologyLevel* level = sval == "node" ? &cfg.hierarchy.node
+                                 : sval == "rack" ? &cfg.hierarchy.rack
+                                 : sval == "cluster" ? &cfg.hierarchy.cluster : nullptr;
+            if (level && (iss >> bw >> lat) && bw > 0.0 && lat >= 0.0) *level = TopologyLevel{bw, lat};
+        }
         else if (key == "memory_pressure_policy" && (iss >> sval)) {
             sval = to_lower(sval);
             if (sval == "reject") cfg.policy.memory_pressure_policy = MemoryPressurePolicy::Reject;
@@ -84,7 +259,7 @@ bool load_config(const std::string& path, SimConfig& cfg, std::string& err) {
         else if (key == "decode_sharing_cap" && (iss >> ival)) cfg.gpus[0].decode_sharing_cap = ival;
         else if (key == "decode_efficiency" && (iss >> dval)) cfg.gpus[0].decode_efficiency = dval;
         else if (key == "gpu") {
-            // Format: gpu <id> [vram <bytes>] [prefill_tps <val>] [decode_tps <val>]
+            // Format: gpu <id> [vram <bytes>] [prefill_tps <val>] [decode_tps <val>] [models <a,b,...>]
             int gpu_id = -1;
             if (!(iss >> gpu_id) || gpu_id < 0) continue;
             
@@ -104,7 +279,9 @@ bool load_config(const std::string& path, SimConfig& cfg, std::string& err) {
                     cfg.gpus[gpu_id].prefill_tps = dval;
                 } else if (subkey == "decode_tps" && (iss >> dval)) {
                     cfg.gpus[gpu_id].decode_tps = dval;
-                } 
+                } else if (subkey == "models" && (iss >> sval)) {
+                    cfg.gpus[gpu_id].models = split_list(sval);
+                }
             }
         }
     }
@@ -1,8 +1,10 @@
 #include "io_output.hpp"
+#include "result_cache.hpp"
 #include <fstream>
 #include <filesystem>
 #include <algorithm>
 #include <chrono>
+#include <cmath>
 
 namespace fs = std::filesystem;
 
@@ -21,6 +23,17 @@ static std::uint64_t fnv1a_file(const std::string& path) {
     return hash;
 }
 
+static const char* scheduling_str(SchedulingMode m) {
+    switch (m) {
+        case SchedulingMode::FIFO: return "fifo";
+        case SchedulingMode::ShortestRemaining: return "shortest_remaining";
+        case SchedulingMode::Priority: return "priority";
+        case SchedulingMode::WeightedFair: return "weighted_fair";
+        case SchedulingMode::PredictedShortest: return "predicted_shortest";
+    }
+    return "unknown";
+}
+
 static bool ensure_dir(const std::string& out_dir, std::string& err) {
     std::error_code ec;
     if (fs::exists(out_dir, ec)) {
@@ -36,28 +49,23 @@ static bool ensure_dir(const std::string& out_dir, std::string& err) {
     return true;
 }
 
-bool write_summary(const std::string& out_dir,
-                   const std::vector<Request>& reqs,
-                   const std::vector<TimeseriesSample>& samples,
-                   std::uint64_t tokens_generated_total,
-                   double sim_end_ms,
-                   const std::vector<EventRecord>& events,
-                   const SimConfig& cfg,
-                   const ExtendedMetrics& ext_metrics,
-                   std::string& err) {
-    if (!ensure_dir(out_dir, err)) return false;
-    std::ofstream ofs(out_dir + "/summary.json");
-    if (!ofs.is_open()) { err = "cannot open summary"; return false; }
+SummaryMetrics compute_summary_metrics(const RequestTable& reqs,
+                                      const std::vector<TimeseriesSample>& samples,
+                                      std::uint64_t tokens_generated_total,
+                                      double sim_end_ms,
+                                      int evictions) {
+    SummaryMetrics m;
+    m.evictions = evictions;
 
     // Latencies
     std::vector<double> latencies;
-    int finished = 0, rejected = 0;
-    for (const auto& r : reqs) {
-        if (r.state == RequestState::Finished) {
-            finished++;
-            latencies.push_back(r.finish_ms - r.arrival_time_ms);
+    for (std::size_t i = 0; i < reqs.size(); ++i) {
+        RequestState state = reqs[i].state;
+        if (state == RequestState::Finished) {
+            m.finished++;
+            latencies.push_back(reqs.finish_ms[i] - reqs.arrival_ms[i]);
         }
-        if (r.state == RequestState::Rejected) rejected++;
+        if (state == RequestState::Rejected) m.rejected++;
     }
     auto pct = [&](double p) {
         if (latencies.empty()) return 0.0;
@@ -65,14 +73,15 @@ bool write_summary(const std::string& out_dir,
         size_t idx = static_cast<size_t>(p * (latencies.size() - 1));
         return latencies[idx];
     };
-    double p50 = pct(0.50);
-    double p95 = pct(0.95);
-    double p99 = pct(0.99);
+    m.p50_latency_ms = pct(0.50);
+    m.p95_latency_ms = pct(0.95);
+    m.p99_latency_ms = pct(0.99);
 
     std::vector<double> ttfts;
-    for (const auto& r : reqs){
+    for (std::size_t i = 0; i < reqs.size(); ++i) {
+        const auto& r = reqs[i];
         if (r.state == RequestState::Finished && r.start_decode_ms > 0.0) {
-            ttfts.push_back(r.start_decode_ms - r.arrival_time_ms);
+            ttfts.push_back(r.start_decode_ms - reqs.arrival_ms[i]);
         }
     }
     auto pct_vec = [&](std::vector<double>& v, double p){
@@ -81,23 +90,21 @@ bool write_summary(const std::string& out_dir,
         size_t idx = static_cast<size_t>(p*(v.size()-1));
         return v[idx];
     };
-    double ttft_p50 = pct_vec(ttfts, 0.50);
-    double ttft_p95 = pct_vec(ttfts, 0.95);
+    m.p50_ttft_ms = pct_vec(ttfts, 0.50);
+    m.p95_ttft_ms = pct_vec(ttfts, 0.95);
 
     // Throughput (tokens/sec) over makespan
-    double makespan_ms = sim_end_ms > 0 ? sim_end_ms : 0.0;
-    double throughput_tps = (makespan_ms > 0.0)
-        ? (static_cast<double>(tokens_generated_total) / (makespan_ms / 1000.0))
+    m.makespan_ms = sim_end_ms > 0 ? sim_end_ms : 0.0;
+    m.throughput_tokens_per_sec = (m.makespan_ms > 0.0)
+        ? (static_cast<double>(tokens_generated_total) / (m.makespan_ms / 1000.0))
         : 0.0;
 
     // Completion / reject rates
     int total = static_cast<int>(reqs.size());
-    double completion_rate = (total > 0) ? static_cast<double>(finished) / total : 0.0;
-    double reject_rate     = (total > 0) ? static_cast<double>(rejected) / total : 0.0;
+    m.completion_rate = (total > 0) ? static_cast<double>(m.finished) / total : 0.0;
+    m.reject_rate     = (total > 0) ? static_cast<double>(m.rejected) / total : 0.0;
 
     // Time-weighted averages from timeseries
-    double avg_vram = 0.0;
-    double busy_ms = 0.0;
     if (samples.size() >= 2) {
         double weighted_vram = 0.0;
         double total_ms = 0.0;
@@ -105,52 +112,156 @@ bool write_summary(const std::string& out_dir,
             double dt = samples[i].time_ms - samples[i-1].time_ms;
             weighted_vram += dt * static_cast<double>(samples[i-1].vram_used);
             if (samples[i-1].active_prefill + samples[i-1].active_decode > 0) {
-                busy_ms += dt;
+                m.gpu_busy_ms += dt;
             }
             total_ms += dt;
         }
         if (total_ms > 0.0) {
-            avg_vram = weighted_vram / total_ms;
+            m.avg_vram_bytes = weighted_vram / total_ms;
         }
     }
+    return m;
+}
 
-    // Policy strings and evict count
+bool write_summary(const std::string& out_dir,
+                   const RequestTable& reqs,
+                   const std::vector<TimeseriesSample>& samples,
+                   std::uint64_t tokens_generated_total,
+                   double sim_end_ms,
+                   int evictions,
+                   const SimConfig& cfg,
+                   const ExtendedMetrics& ext_metrics,
+                   std::string& err) {
+    if (!ensure_dir(out_dir, err)) return false;
+    std::ofstream ofs(out_dir + "/summary.json");
+    if (!ofs.is_open()) { err = "cannot open summary"; return false; }
+    format_summary(ofs, reqs, samples, tokens_generated_total, sim_end_ms, evictions, cfg, ext_metrics);
+    return true;
+}
+
+void format_summary(std::ostream& ofs,
+                    const RequestTable& reqs,
+                    const std::vector<TimeseriesSample>& samples,
+                    std::uint64_t tokens_generated_total,
+                    double sim_end_ms,
+                    int evictions,
+                    const SimConfig& cfg,
+                    const ExtendedMetrics& ext_metrics) {
+    SummaryMetrics m = compute_summary_metrics(reqs, samples, tokens_generated_total, sim_end_ms, evictions);
+    double makespan_ms = m.makespan_ms;
+
+    // Policy strings
     auto policy_to_str = [](MemoryPressurePolicy p) {
         return (p == MemoryPressurePolicy::Evict) ? "evict" : "reject";
     };
     auto evict_policy_to_str = [](EvictionPolicy p) {
         return (p == EvictionPolicy::LRU) ? "lru" : "fifo";
     };
-    int evict_count = 0;
-    for (const auto& e : events) {
-        if (e.type == EventType::Evict) evict_count++;
-    }
 
     ofs << "{\n"
-        << "  \"finished\": " << finished << ",\n"
-        << "  \"rejected\": " << rejected << ",\n"
-        << "  \"completion_rate\": " << completion_rate << ",\n"
-        << "  \"reject_rate\": " << reject_rate << ",\n"
-        << "  \"throughput_tokens_per_sec\": " << throughput_tps << ",\n"
-        << "  \"p50_latency_ms\": " << p50 << ",\n"
-        << "  \"p95_latency_ms\": " << p95 << ",\n"
-        << "  \"p99_latency_ms\": " << p99 << ",\n"
-        << "  \"p50_ttft_ms\": " << ttft_p50 << ",\n"
-        << "  \"p95_ttft_ms\": " << ttft_p95 << ",\n"
-        << "  \"avg_vram_bytes\": " << avg_vram << ",\n"
-        << "  \"gpu_busy_ms\": " << busy_ms << ",\n"
-        << "  \"makespan_ms\": " << makespan_ms << ",\n"
+        << "  \"finished\": " << m.finished << ",\n"
+        << "  \"rejected\": " << m.rejected << ",\n"
+        << "  \"completion_rate\": " << m.completion_rate << ",\n"
+        << "  \"reject_rate\": " << m.reject_rate << ",\n"
+        << "  \"throughput_tokens_per_sec\": " << m.throughput_tokens_per_sec << ",\n"
+        << "  \"p50_latency_ms\": " << m.p50_latency_ms << ",\n"
+        << "  \"p95_latency_ms\": " << m.p95_latency_ms << ",\n"
+        << "  \"p99_latency_ms\": " << m.p99_latency_ms << ",\n"
+        << "  \"p50_ttft_ms\": " << m.p50_ttft_ms << ",\n"
+        << "  \"p95_ttft_ms\": " << m.p95_ttft_ms << ",\n"
+        << "  \"avg_vram_bytes\": " << m.avg_vram_bytes << ",\n"
+        << "  \"gpu_busy_ms\": " << m.gpu_busy_ms << ",\n"
+        << "  \"makespan_ms\": " << m.makespan_ms << ",\n"
         << "  \"memory_pressure_policy\": \"" << policy_to_str(cfg.policy.memory_pressure_policy) << "\",\n";
     if (cfg.policy.memory_pressure_policy == MemoryPressurePolicy::Evict) {
         ofs << "  \"eviction_policy\": \"" << evict_policy_to_str(cfg.policy.eviction_policy) << "\",\n";
     }
-    ofs << "  \"evictions\": " << evict_count << ",\n";
+    ofs << "  \"evictions\": " << m.evictions << ",\n";
 
     ofs << "  \"retry_attempts\": " << ext_metrics.retry_attempts << ",\n"
         << "  \"retry_successes\": " << ext_metrics.retry_successes << ",\n"
         << "  \"handoffs_total\": " << ext_metrics.handoffs_total << ",\n"
         << "  \"cross_gpu_decodes\": " << ext_metrics.cross_gpu_decodes << ",\n"
         << "  \"max_global_queue_depth\": " << ext_metrics.max_global_queue_depth << ",\n";
+    if (cfg.policy.global_dispatch == GlobalDispatch::Backfill) {
+        ofs << "  \"global_backfills\": " << ext_metrics.global_backfills << ",\n";
+    }
+
+    if (cfg.policy.handoff_mode == HandoffMode::Layerwise) {
+        // Hidden = transfer time the layerwise stream overlapped with prefill
+        double hidden_ms = ext_metrics.handoff_whole_ms - ext_metrics.handoff_exposed_ms;
+        double hidden_frac = (ext_metrics.handoff_whole_ms > 0.0) ? hidden_ms / ext_metrics.handoff_whole_ms : 0.0;
+        double n = ext_metrics.handoffs_pipelined > 0 ? ext_metrics.handoffs_pipelined : 1;
+        ofs << "  \"handoffs_pipelined\": " << ext_metrics.handoffs_pipelined << ",\n"
+            << "  \"handoff_avg_whole_ms\": " << ext_metrics.handoff_whole_ms / n << ",\n"
+            << "  \"handoff_avg_exposed_ms\": " << ext_metrics.handoff_exposed_ms / n << ",\n"
+            << "  \"handoff_hidden_ms\": " << hidden_ms << ",\n"
+            << "  \"handoff_hidden_fraction\": " << hidden_frac << ",\n";
+    }
+
+    if (cfg.policy.length_predictor != LengthPredictor::Oracle || cfg.policy.predicted_reservation) {
+        double abs_err = 0.0, signed_err = 0.0;
+        for (const auto& r : reqs.hot) {
+            double diff = static_cast<double>(r.predicted_gen_tokens - r.gen_tokens);
+            abs_err += std::abs(diff);
+            signed_err += diff;
+        }
+        double n = reqs.empty() ? 1.0 : static_cast<double>(reqs.size());
+        ofs << "  \"length_prediction_mae_tokens\": " << abs_err / n << ",\n"
+            << "  \"length_prediction_bias_tokens\": " << signed_err / n << ",\n"
+            << "  \"kv_growth_steps\": " << ext_metrics.kv_growth_steps << ",\n"
+            << "  \"kv_growth_failures\": " << ext_metrics.kv_growth_failures << ",\n";
+    }
+
+    if (cfg.policy.spec_decode.enabled) {
+        double tokens_per_step = (ext_metrics.spec_steps_total > 0.0)
+            ? static_cast<double>(ext_metrics.spec_tokens_total) / ext_metrics.spec_steps_total
+            : 0.0;
+        ofs << "  \"spec_decode_steps\": " << ext_metrics.spec_steps_total << ",\n"
+            << "  \"spec_tokens_per_step\": " << tokens_per_step << ",\n"
+            << "  \"spec_fallbacks\": " << ext_metrics.spec_fallbacks << ",\n";
+    }
+
+    if (ext_metrics.num_sessions > 0) {
+        double hit_rate = (ext_metrics.session_followups > 0)
+            ? static_cast<double>(ext_metrics.session_hits) / ext_metrics.session_followups
+            : 0.0;
+        ofs << "  \"sessions\": " << ext_metrics.num_sessions << ",\n"
+            << "  \"session_followups\": " << ext_metrics.session_followups << ",\n"
+            << "  \"session_hits\": " << ext_metrics.session_hits << ",\n"
+            << "  \"session_hit_rate\": " << hit_rate << ",\n"
+            << "  \"session_reused_tokens\": " << ext_metrics.session_reused_tokens << ",\n"
+            << "  \"session_prefill_saved_ms\": " << ext_metrics.session_prefill_saved_ms << ",\n"
+            << "  \"session_kv_retained\": " << ext_metrics.session_retained << ",\n"
+            << "  \"session_kv_expired\": " << ext_metrics.session_expired << ",\n"
+            << "  \"session_kv_pressure_drops\": " << ext_metrics.session_pressure_drops << ",\n";
+    }
+
+    if (ext_metrics.timeouts) {
+        // Work the cluster did for clients that gave up before their request finished
+        int abandoned = ext_metrics.abandoned_queued + ext_metrics.abandoned_prefill + ext_metrics.abandoned_decode;
+        double decoded = static_cast<double>(tokens_generated_total) + ext_metrics.abandoned_decode_tokens;
+        ofs << "  \"abandoned\": " << abandoned << ",\n"
+            << "  \"abandon_rate\": " << (reqs.empty() ? 0.0 : static_cast<double>(abandoned) / reqs.size()) << ",\n"
+            << "  \"abandoned_queued\": " << ext_metrics.abandoned_queued << ",\n"
+            << "  \"abandoned_prefill\": " << ext_metrics.abandoned_prefill << ",\n"
+            << "  \"abandoned_decode\": " << ext_metrics.abandoned_decode << ",\n"
+            << "  \"abandoned_prefill_ms\": " << ext_metrics.abandoned_prefill_ms << ",\n"
+            << "  \"abandoned_decode_tokens\": " << ext_metrics.abandoned_decode_tokens << ",\n"
+            << "  \"decode_goodput_fraction\": " << (decoded > 0.0 ? tokens_generated_total / decoded : 0.0) << ",\n";
+    }
+
+    if (cfg.flight.events > 0) {
+        ofs << "  \"flight_recorder_events\": " << cfg.flight.events << ",\n"
+            << "  \"flight_events_recorded\": " << ext_metrics.flight_events_recorded << ",\n"
+            << "  \"flight_dumps\": [";
+        for (std::size_t i = 0; i < ext_metrics.flight_dumps.size(); ++i) {
+            const auto& d = ext_metrics.flight_dumps[i];
+            ofs << (i ? ",\n" : "\n") << "    {\"file\": \"" << d.file << "\", \"time_ms\": " << d.time_ms
+                << ", \"reason\": \"" << d.reason << "\", \"events\": " << d.events << "}";
+        }
+        ofs << (ext_metrics.flight_dumps.empty() ? "],\n" : "\n  ],\n");
+    }
 
     ofs << "  \"per_gpu\": [\n";
     for (size_t i = 0; i < ext_metrics.peak_vram_per_gpu.size(); ++i) {
@@ -161,17 +272,93 @@ bool write_summary(const std::string& out_dir,
         if (i + 1 < ext_metrics.peak_vram_per_gpu.size()) ofs << ",";
         ofs << "\n";
     }
-    ofs << "  ]\n";
+    ofs << "  ]";
 
-    ofs << "}\n";
-    return true;
+    if (!ext_metrics.tenants.empty()) {
+        // Goodput counts only tokens from requests that met their tenant's TTFT SLO
+        size_t nt = ext_metrics.tenants.size();
+        std::vector<int> t_total(nt, 0), t_finished(nt, 0), t_rejected(nt, 0), t_attained(nt, 0);
+        std::vector<std::uint64_t> t_good_tokens(nt, 0);
+        for (std::size_t i = 0; i < reqs.size(); ++i) {
+            const auto& r = reqs[i];
+            if (r.tenant_idx < 0 || r.tenant_idx >= static_cast<int>(nt)) continue;
+            size_t t = static_cast<size_t>(r.tenant_idx);
+            t_total[t]++;
+            if (r.state == RequestState::Rejected) t_rejected[t]++;
+            if (r.state != RequestState::Finished) continue;
+            t_finished[t]++;
+            double slo = ext_metrics.tenants[t].ttft_slo_ms;
+            if (slo <= 0.0 || r.start_decode_ms - reqs.arrival_ms[i] <= slo) {
+                t_attained[t]++;
+                t_good_tokens[t] += static_cast<std::uint64_t>(r.gen_tokens);
+            }
+        }
+        ofs << ",\n  \"tenants\": [\n";
+        for (size_t t = 0; t < nt; ++t) {
+            const auto& tm = ext_metrics.tenants[t];
+            double attainment = (t_total[t] > 0) ? static_cast<double>(t_attained[t]) / t_total[t] : 0.0;
+            double goodput = (makespan_ms > 0.0)
+                ? static_cast<double>(t_good_tokens[t]) / (makespan_ms / 1000.0)
+                : 0.0;
+            ofs << "    {\"tenant\": \"" << tm.name << "\""
+                << ", \"requests\": " << t_total[t]
+                << ", \"finished\": " << t_finished[t]
+                << ", \"rejected\": " << t_rejected[t]
+                << ", \"rate_limited\": " << tm.rate_limited
+                << ", \"quota_rejected\": " << tm.quota_rejected
+                << ", \"slo_rejected\": " << tm.slo_rejected
+                << ", \"ttft_slo_ms\": " << tm.ttft_slo_ms
+                << ", \"slo_attainment\": " << attainment
+                << ", \"goodput_tokens_per_sec\": " << goodput << "}";
+            if (t + 1 < nt) ofs << ",";
+            ofs << "\n";
+        }
+        ofs << "  ]";
+    }
+
+    if (!ext_metrics.models.empty()) {
+        size_t nm = ext_metrics.models.size();
+        std::vector<int> m_total(nm, 0), m_finished(nm, 0), m_rejected(nm, 0);
+        std::vector<std::uint64_t> m_tokens(nm, 0);
+        for (const auto& r : reqs.hot) {
+            if (r.model_idx < 0 || r.model_idx >= static_cast<int>(nm)) continue;
+            size_t m = static_cast<size_t>(r.model_idx);
+            m_total[m]++;
+            if (r.state == RequestState::Rejected) m_rejected[m]++;
+            if (r.state != RequestState::Finished) continue;
+            m_finished[m]++;
+            m_tokens[m] += static_cast<std::uint64_t>(r.gen_tokens);
+        }
+        ofs << ",\n  \"models\": [\n";
+        for (size_t m = 0; m < nm; ++m) {
+            const auto& mm = ext_metrics.models[m];
+            ofs << "    {\"model\": \"" << mm.name << "\""
+                << ", \"gpus\": " << mm.gpus
+                << ", \"weights_bytes\": " << mm.weights_bytes
+                << ", \"kv_bytes_per_token\": " << mm.kv_bytes_per_token
+                << ", \"requests\": " << m_total[m]
+                << ", \"finished\": " << m_finished[m]
+                << ", \"rejected\": " << m_rejected[m]
+                << ", \"tokens_generated\": " << m_tokens[m]
+                << ", \"swap_ins\": " << mm.swap_ins << "}";
+            if (m + 1 < nm) ofs << ",";
+            ofs << "\n";
+        }
+        ofs << "  ]";
+    }
+
+    ofs << "\n}\n";
 }
 
 bool write_timeseries_csv(const std::string& out_dir, const std::vector<TimeseriesSample>& samples, int num_gpus, std::string& err) {
     if (!ensure_dir(out_dir, err)) return false;
     std::ofstream ofs(out_dir + "/timeseries.csv");
     if (!ofs.is_open()) { err = "cannot open timeseries"; return false; }
+    format_timeseries_csv(ofs, samples, num_gpus);
+    return true;
+}
 
+void format_timeseries_csv(std::ostream& ofs, const std::vector<TimeseriesSample>& samples, int num_gpus) {
     // Header: original columns + per-GPU VRAM + global queue depth
     ofs << "time_ms,vram_used,active_prefill,active_decode,queue_depth,tokens_generated_delta,rejects_delta";
     for (int i = 0; i < num_gpus; ++i) {
@@ -194,10 +381,9 @@ bool write_timeseries_csv(const std::string& out_dir, const std::vector<Timeseri
         }
         ofs << "," << s.global_queue_depth << "\n";
     }
-    return true;
 }
 
-static std::string event_type_str(EventType t) {
+std::string event_type_str(EventType t) {
     switch (t) {
         case EventType::Arrival: return "arrival";
         case EventType::Enqueue: return "enqueue";
@@ -208,6 +394,10 @@ static std::string event_type_str(EventType t) {
         case EventType::Finish: return "finish";
         case EventType::Reject: return "reject";
         case EventType::Evict: return "evict";
+        case EventType::KvGrow: return "kv_grow";
+        case EventType::SessionExpire: return "session_expire";
+        case EventType::Abandon: return "abandon";
+        case EventType::TimerTick: return "timer_tick";
     }
     return "unknown";
 }
@@ -216,6 +406,11 @@ bool write_events_jsonl(const std::string& out_dir, const std::vector<EventRecor
     if (!ensure_dir(out_dir, err)) return false;
     std::ofstream ofs(out_dir + "/events.jsonl");
     if (!ofs.is_open()) { err = "cannot open events"; return false; }
+    format_events_jsonl(ofs, events);
+    return true;
+}
+
+void format_events_jsonl(std::ostream& ofs, const std::vector<EventRecord>& events) {
     for (const auto& e : events) {
         ofs << "{"
             << "\"time_ms\":" << e.time_ms << ","
@@ -224,7 +419,6 @@ bool write_events_jsonl(const std::string& out_dir, const std::vector<EventRecor
             << "\"gpu_index\":" << e.gpu_index
             << "}\n";
     }
-    return true;
 }
 
 bool write_run_meta(const std::string& out_dir, const SimConfig& cfg, std::string& err) {
@@ -240,7 +434,7 @@ bool write_run_meta(const std::string& out_dir, const SimConfig& cfg, std::strin
         << "  \"timeseries_dt_ms\": " << cfg.timeseries_dt_ms << ",\n"
         << "  \"timestamp_ms\": " << ms << ",\n"
         << "  \"config_hash\": " << cfg_hash << ",\n"
-        << "  \"scheduling\": \"" << (cfg.policy.scheduling == SchedulingMode::FIFO ? "fifo" : "shortest_remaining") << "\",\n"
+        << "  \"scheduling\": \"" << scheduling_str(cfg.policy.scheduling) << "\",\n"
         << "  \"memory_pressure_policy\": \"" << (cfg.policy.memory_pressure_policy == MemoryPressurePolicy::Evict ? "evict" : "reject") << "\",\n"
         << "  \"eviction_policy\": \"" << (cfg.policy.eviction_policy == EvictionPolicy::LRU ? "lru" : "fifo") << "\",\n"
         << "  \"decode_sharing_cap\": " << cfg.gpus[0].decode_sharing_cap << ",\n"
@@ -262,11 +456,92 @@ bool write_run_meta(const std::string& out_dir, const SimConfig& cfg, std::strin
         << "  \"timeseries_dt_ms\": " << cfg.timeseries_dt_ms << ",\n"
         << "  \"timestamp_ms\": " << ms << ",\n"
         << "  \"config_hash\": " << cfg_hash << ",\n"
-        << "  \"scheduling\": \"" << (cfg.policy.scheduling == SchedulingMode::FIFO ? "fifo" : "shortest_remaining") << "\",\n"
+        << "  \"effective_config_hash\": " << hash_config(cfg) << ",\n"
+        << "  \"build_id\": \"" << kv_sim_build_id() << "\",\n"
+        << "  \"scheduling\": \"" << scheduling_str(cfg.policy.scheduling) << "\",\n"
         << "  \"memory_pressure_policy\": \"" << (cfg.policy.memory_pressure_policy == MemoryPressurePolicy::Evict ? "evict" : "reject") << "\",\n"
         << "  \"eviction_policy\": \"" << (cfg.policy.eviction_policy == EvictionPolicy::LRU ? "lru" : "fifo") << "\",\n"
         << "  \"decode_sharing_cap\": " << cfg.gpus[0].decode_sharing_cap << ",\n"
         << "  \"decode_efficiency\": " << cfg.gpus[0].decode_efficiency << "\n"
         << "}\n";
     return true;
+}
+
+bool write_replications_json(const std::string& out_dir, const ReplicationOptions& opts, const ReplicationResult& result, std::string& err) {
+    if (!ensure_dir(out_dir, err)) return false;
+    std::ofstream ofs(out_dir + "/replications.json");
+    if (!ofs.is_open()) { err = "cannot open replications"; return false; }
+
+    ofs << "{\n"
+        << "  \"replications\": " << result.samples.size() << ",\n"
+        << "  \"max_replications\": " << opts.max_replications << ",\n"
+        << "  \"ci_level\": " << opts.ci_level << ",\n"
+        << "  \"ci_target\": " << opts.ci_target << ",\n"
+        << "  \"converged\": " << (result.converged ? "true" : "false") << ",\n"
+        << "  \"metrics\": {\n";
+    for (std::size_t i = 0; i < result.estimates.size(); ++i) {
+        const auto& e = result.estimates[i];
+        ofs << "    \"" << e.name << "\": {"
+            << "\"mean\": " << e.mean << ", "
+            << "\"stddev\": " << e.stddev << ", "
+            << "\"ci_low\": " << e.mean - e.half_width << ", "
+            << "\"ci_high\": " << e.mean + e.half_width << ", "
+            << "\"half_width\": " << e.half_width << "}"
+            << (i + 1 < result.estimates.size() ? "," : "") << "\n";
+    }
+    ofs << "  },\n"
+        << "  \"runs\": [\n";
+    for (std::size_t i = 0; i < result.samples.size(); ++i) {
+        const auto& s = result.samples[i];
+        ofs << "    {\"replication\": " << i
+            << ", \"p50_latency_ms\": " << s.p50_latency_ms
+            << ", \"p99_latency_ms\": " << s.p99_latency_ms
+            << ", \"throughput_tokens_per_sec\": " << s.throughput_tokens_per_sec
+            << ", \"reject_rate\": " << s.reject_rate << "}"
+            << (i + 1 < result.samples.size() ? "," : "") << "\n";
+    }
+    ofs << "  ]\n"
+        << "}\n";
+    return true;
+}
+
+bool write_perf_json(const std::string& out_dir, const PerfStats& perf, std::string& err) {
+    if (!ensure_dir(out_dir, err)) return false;
+    std::ofstream ofs(out_dir + "/perf.json");
+    if (!ofs.is_open()) { err = "cannot open perf"; return false; }
+
+    auto ms = [](std::uint64_t ns) { return static_cast<double>(ns) / 1e6; };
+    double run_s = static_cast<double>(perf.run_ns) / 1e9;
+    double events_per_sec = run_s > 0.0 ? static_cast<double>(perf.events_processed) / run_s : 0.0;
+    double pq_mean = perf.events_processed > 0 ? perf.pq_size_sum / static_cast<double>(perf.events_processed) : 0.0;
+
+    ofs << "{\n"
+        << "  \"events_processed\": " << perf.events_processed << ",\n"
+        << "  \"run_wall_ms\": " << ms(perf.run_ns) << ",\n"
+        << "  \"events_per_sec\": " << events_per_sec << ",\n"
+        << "  \"pq_high_water\": " << perf.pq_high_water << ",\n"
+        << "  \"pq_mean_size\": " << pq_mean << ",\n"
+        << "  \"events_cancelled\": " << perf.events_cancelled << ",\n"
+        << "  \"dead_events_skipped\": " << perf.dead_events_skipped << ",\n"
+        << "  \"dead_events_compacted\": " << perf.dead_events_compacted << ",\n"
+        << "  \"heap_compactions\": " << perf.heap_compactions << ",\n"
+        << "  \"routing_calls\": " << perf.routing_calls << ",\n"
+        << "  \"routing_ms\": " << ms(perf.routing_ns) << ",\n"
+        << "  \"sampling_ms\": " << ms(perf.sampling_ns) << ",\n"
+        << "  \"output_ms\": " << ms(perf.output_ns) << ",\n"
+        << "  \"handlers\": {\n";
+    bool first = true;
+    for (int t = 0; t < kNumEventTypes; ++t) {
+        if (perf.event_counts[t] == 0) continue;
+        double wall_ms = ms(perf.handler_ns[t]);
+        ofs << (first ? "" : ",\n")
+            << "    \"" << event_type_str(static_cast<EventType>(t)) << "\": {"
+            << "\"count\": " << perf.event_counts[t] << ", "
+            << "\"wall_ms\": " << wall_ms << ", "
+            << "\"mean_us\": " << wall_ms * 1000.0 / static_cast<double>(perf.event_counts[t]) << "}";
+        first = false;
+    }
+    ofs << "\n  }\n"
+        << "}\n";
+    return true;
 }
\ No newline at end of file
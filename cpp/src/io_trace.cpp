@@ -1,25 +1,217 @@
 #include "io_trace.hpp"
+#include <algorithm>
+#include <charconv>
+#include <fcntl.h>
 #include <fstream>
-#include <sstream>
+#include <iterator>
+#include <string_view>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
 
-bool load_trace(const std::string& path, std::vector<Request>& out, std::string& err) {
-    std::ifstream f(path);
-    if (!f.is_open()) {
-        err = "trace file not found";
+// Text traces are parsed straight from a file mapping (or one bulk read) with
+// std::from_chars. Large inputs are cut into newline-aligned chunks parsed on
+// separate threads; chunks are concatenated in file order, so request order and
+// the first error reported are the same as a single sequential pass.
+namespace {
+
+constexpr std::size_t kMinChunkBytes = 1 << 20;
+
+bool is_space(char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f'; }
+
+class LineCursor {
+public:
+    explicit LineCursor(std::string_view line) : p_(line.data()), end_(line.data() + line.size()) {}
+
+    bool next(std::string_view& tok) {
+        while (p_ < end_ && is_space(*p_)) ++p_;
+        if (p_ == end_) return false;
+        const char* start = p_;
+        while (p_ < end_ && !is_space(*p_)) ++p_;
+        tok = std::string_view(start, static_cast<std::size_t>(p_ - start));
+        return true;
+    }
+
+    template <typename T>
+    bool next_number(T& v) {
+        std::string_view tok;
+        if (!next(tok)) return false;
+        auto res = std::from_chars(tok.data(), tok.data() + tok.size(), v);
+        return res.ec == std::errc() && res.ptr == tok.data() + tok.size();
+    }
+
+    bool next_string(std::string& s) {
+        std::string_view tok;
+        if (!next(tok)) return false;
+        s.assign(tok.data(), tok.size());
+        return true;
+    }
+
+private:
+    const char* p_;
+    const char* end_;
+};
+
+// Parses one non-comment line; on failure sets err to the reason
+bool parse_line(std::string_view line, Request& r, std::string& err) {
+    LineCursor cur(line);
+    int streaming_int = 0;
+    if (!(cur.next_string(r.id) && cur.next_number(r.arrival_time_ms) && cur.next_number(r.prompt_tokens) &&
+          cur.next_number(r.gen_tokens) && cur.next_number(streaming_int))) {
+        err = "failed to parse";
         return false;
     }
-    std::string line;
-    while (std::getline(f, line)) {
+    r.streaming = (streaming_int != 0);
+    // Optional trailing <key> <value> columns
+    std::string_view key;
+    while (cur.next(key)) {
+        if (key == "priority") {
+            if (!cur.next_number(r.priority) || r.priority < 0) {
+                err = "invalid priority";
+                return false;
+            }
+            if (r.priority > kMaxPriority) {
+                err = "priority above " + std::to_string(kMaxPriority);
+                return false;
+            }
+        } else if (key == "tenant") {
+            if (!cur.next_string(r.tenant)) {
+                err = "missing tenant";
+                return false;
+            }
+        } else if (key == "model") {
+            if (!cur.next_string(r.model)) {
+                err = "missing model";
+                return false;
+            }
+        } else if (key == "session") {
+            if (!cur.next_string(r.session)) {
+                err = "missing session";
+                return false;
+            }
+        } else if (key == "turn") {
+            if (!cur.next_number(r.turn) || r.turn < 0) {
+                err = "invalid turn";
+                return false;
+            }
+        } else if (key == "timeout") {
+            if (!cur.next_number(r.timeout_ms) || !(r.timeout_ms >= 0.0)) {
+                err = "invalid timeout";
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+struct Chunk {
+    std::string_view text;
+    std::vector<Request> requests;
+    std::size_t lines = 0;       // newline-terminated or final lines seen
+    std::size_t error_line = 0;  // 1-based within the chunk; 0 = none
+    std::string err;
+    std::string_view error_text;
+};
+
+void parse_chunk(Chunk& c) {
+    const char* p = c.text.data();
+    const char* end = p + c.text.size();
+    c.requests.reserve(static_cast<std::size_t>(std::count(p, end, '\n')) + 1);
+    while (p < end) {
+        const char* nl = std::find(p, end, '\n');
+        std::string_view line(p, static_cast<std::size_t>(nl - p));
+        p = (nl == end) ? end : nl + 1;
+        ++c.lines;
         if (line.empty() || line[0] == '#') continue;
-        std::istringstream iss(line);
         Request r;
-        int streaming_int = 0;
-        if (!(iss >> r.id >> r.arrival_time_ms >> r.prompt_tokens >> r.gen_tokens >> streaming_int)) {
-            err = "failed to parse line: " + line;
+        if (!parse_line(line, r, c.err)) {
+            c.error_line = c.lines;
+            c.error_text = line;
+            return;
+        }
+        c.requests.push_back(std::move(r));
+    }
+}
+
+}  // namespace
+
+bool load_trace_buffer(const char* data, std::size_t size, std::vector<Request>& out, std::string& err, int threads) {
+    if (threads <= 0) threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    std::size_t n_chunks = std::max<std::size_t>(1, std::min<std::size_t>(threads, size / kMinChunkBytes));
+
+    // Newline-aligned cut points
+    std::vector<Chunk> chunks;
+    chunks.reserve(n_chunks);
+    const char* end = data + size;
+    const char* start = data;
+    for (std::size_t i = 0; i < n_chunks && start < end; ++i) {
+        const char* stop = end;
+        if (i + 1 < n_chunks) {
+            stop = std::min(end, data + size * (i + 1) / n_chunks);
+            stop = std::find(std::max(stop, start), end, '\n');
+            if (stop != end) ++stop;
+        }
+        chunks.emplace_back();
+        chunks.back().text = std::string_view(start, static_cast<std::size_t>(stop - start));
+        start = stop;
+    }
+
+    if (chunks.size() == 1) {
+        parse_chunk(chunks[0]);
+    } else {
+        std::vector<std::thread> workers;
+        for (std::size_t i = 1; i < chunks.size(); ++i) workers.emplace_back(parse_chunk, std::ref(chunks[i]));
+        parse_chunk(chunks[0]);
+        for (auto& t : workers) t.join();
+    }
+
+    std::size_t line_base = 0;
+    std::size_t total = 0;
+    for (const auto& c : chunks) {
+        if (c.error_line != 0) {
+            err = c.err + " on line " + std::to_string(line_base + c.error_line) + ": " + std::string(c.error_text);
             return false;
         }
-        r.streaming = (streaming_int != 0);
-        out.push_back(std::move(r));
+        line_base += c.lines;
+        total += c.requests.size();
+    }
+    if (out.empty() && chunks.size() == 1) {
+        out.swap(chunks[0].requests);
+        return true;
+    }
+    out.reserve(out.size() + total);
+    for (auto& c : chunks) {
+        out.insert(out.end(), std::make_move_iterator(c.requests.begin()), std::make_move_iterator(c.requests.end()));
+        std::vector<Request>().swap(c.requests);
     }
     return true;
-}
\ No newline at end of file
+}
+
+bool load_trace(const std::string& path, std::vector<Request>& out, std::string& err) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        err = "trace file not found";
+        return false;
+    }
+    struct stat st {};
+    bool regular = ::fstat(fd, &st) == 0 && S_ISREG(st.st_mode);
+    std::size_t size = regular ? static_cast<std::size_t>(st.st_size) : 0;
+    void* map = (size > 0) ? ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+    ::close(fd);
+    if (regular && size == 0) return true;
+    if (map == MAP_FAILED) {
+        // Pipes and other unmappable inputs take one bulk read instead
+        std::ifstream f(path, std::ios::binary);
+        return load_trace_stream(f, out, err);
+    }
+    ::madvise(map, size, MADV_SEQUENTIAL);
+    bool ok = load_trace_buffer(static_cast<const char*>(map), size, out, err);
+    ::munmap(map, size);
+    return ok;
+}
+
+bool load_trace_stream(std::istream& f, std::vector<Request>& out, std::string& err) {
+    std::string text(std::istreambuf_iterator<char>(f), {});
+    return load_trace_buffer(text.data(), text.size(), out, err);
+}
@@ -0,0 +1,155 @@
+#include "kv_sim.hpp"
+#include <sstream>
+#include "simulator.hpp"
+
+static void drain(RequestSource& source, std::vector<Request>& out) {
+    out.clear();
+    Request r;
+    while (source.next(r)) out.push_back(std::move(r));
+}
+
+static std::vector<Request> drain(RequestSource& source) {
+    std::vector<Request> out;
+    drain(source, out);
+    return out;
+}
+
+SimSession::SimSession(SimConfig cfg, std::vector<Request> requests)
+    : cfg_(cfg), sim_(std::make_unique<Simulator>(std::move(cfg), std::move(requests))) {
+    sim_->set_verbose(false);
+    sim_->set_stop_flag(&cancel_);
+}
+
+SimSession::SimSession(SimConfig cfg, RequestSource& source) : SimSession(std::move(cfg), drain(source)) {}
+
+SimSession::~SimSession() = default;
+
+void SimSession::reset(SimConfig cfg, const std::vector<Request>& requests) {
+    cfg_ = cfg;
+    sim_->reset(std::move(cfg), requests);
+    cancel_.store(false, std::memory_order_relaxed);
+    done_ = false;
+}
+
+void SimSession::reset(SimConfig cfg, RequestSource& source) {
+    drain(source, staging_);
+    reset(std::move(cfg), staging_);
+}
+
+void SimSession::run(int threads) {
+    if (done_) return;
+    if (threads > 1) {
+        sim_->run_parallel(threads);
+    } else {
+        sim_->run();
+    }
+    done_ = true;
+}
+
+bool SimSession::step_until(double t_ms) {
+    if (done_) return false;
+    sim_->run_until(t_ms);
+    // Finalize (totals, makespan) as soon as the last event has been handled
+    if (sim_->idle() || cancelled()) run();
+    return !done_;
+}
+
+bool SimSession::run_for(std::size_t n_events) {
+    if (done_) return false;
+    sim_->run_for(n_events);
+    if (sim_->idle() || cancelled()) run();
+    return !done_;
+}
+
+double SimSession::now_ms() const { return sim_->now_ms(); }
+
+void SimSession::set_verbose(bool verbose) { sim_->set_verbose(verbose); }
+
+RunResult SimSession::result() const {
+    RunResult r;
+    double end_ms = done_ ? sim_->sim_end_ms() : sim_->now_ms();
+    r.summary = compute_summary_metrics(sim_->requests(), sim_->samples(), sim_->tokens_generated_total(), end_ms,
+                                        sim_->evictions());
+    r.extended = collect_extended_metrics(*sim_, cfg_);
+    r.perf = sim_->perf_stats();
+    return r;
+}
+
+std::string SimSession::summary_json() const {
+    std::ostringstream os;
+    double end_ms = done_ ? sim_->sim_end_ms() : sim_->now_ms();
+    format_summary(os, sim_->requests(), sim_->samples(), sim_->tokens_generated_total(), end_ms, sim_->evictions(),
+                   cfg_, collect_extended_metrics(*sim_, cfg_));
+    return os.str();
+}
+
+bool SimSession::write_outputs(const std::string& out_dir, std::string& err, const std::string& config_path) const {
+    ExtendedMetrics ext_metrics = collect_extended_metrics(*sim_, cfg_);
+    bool ok = true;
+    if (!write_summary(out_dir, sim_->requests(), sim_->samples(), sim_->tokens_generated_total(), sim_->sim_end_ms(),
+                       sim_->evictions(), cfg_, ext_metrics, err)) {
+        return false;
+    }
+    ok = ok && write_timeseries_csv(out_dir, sim_->samples(), sim_->num_gpus(), err);
+    ok = ok && write_events_jsonl(out_dir, sim_->events(), err);
+    if (sim_->flight_recorder().enabled()) ok = ok && sim_->flight_recorder().write_held_dumps(out_dir, err);
+    ok = ok && write_run_meta(out_dir, cfg_, err, config_path);
+    return ok;
+}
+
+ExtendedMetrics collect_extended_metrics(const Simulator& sim, const SimConfig& cfg) {
+    ExtendedMetrics ext_metrics;
+    ext_metrics.retry_attempts = sim.retry_attempts();
+    ext_metrics.retry_successes = sim.retry_successes();
+    ext_metrics.handoffs_total = sim.handoffs_total();
+    ext_metrics.handoffs_pipelined = sim.handoffs_pipelined();
+    ext_metrics.handoff_whole_ms = sim.handoff_whole_ms();
+    ext_metrics.handoff_exposed_ms = sim.handoff_exposed_ms();
+    ext_metrics.cross_gpu_decodes = sim.cross_gpu_decodes();
+    ext_metrics.max_global_queue_depth = sim.max_global_queue_depth();
+    ext_metrics.global_backfills = sim.global_backfills();
+    ext_metrics.kv_growth_steps = sim.kv_growth_steps();
+    ext_metrics.kv_growth_failures = sim.kv_growth_failures();
+    ext_metrics.spec_steps_total = sim.spec_steps_total();
+    ext_metrics.spec_tokens_total = sim.spec_tokens_total();
+    ext_metrics.spec_fallbacks = sim.spec_fallbacks();
+    ext_metrics.num_sessions = sim.num_sessions();
+    ext_metrics.session_followups = sim.session_followups();
+    ext_metrics.session_hits = sim.session_hits();
+    ext_metrics.session_reused_tokens = sim.session_reused_tokens();
+    ext_metrics.session_prefill_saved_ms = sim.session_prefill_saved_ms();
+    ext_metrics.session_retained = sim.session_retained();
+    ext_metrics.session_expired = sim.session_expired();
+    ext_metrics.session_pressure_drops = sim.session_pressure_drops();
+    ext_metrics.timeouts = sim.timeouts_enabled();
+    ext_metrics.abandoned_queued = sim.abandoned_queued();
+    ext_metrics.abandoned_prefill = sim.abandoned_prefill();
+    ext_metrics.abandoned_decode = sim.abandoned_decode();
+    ext_metrics.abandoned_prefill_ms = sim.abandoned_prefill_ms();
+    ext_metrics.abandoned_decode_tokens = sim.abandoned_decode_tokens();
+    const auto& flight = sim.flight_recorder();
+    if (flight.enabled()) {
+        ext_metrics.flight_events_recorded = flight.recorded();
+        for (std::size_t k = 0; k < flight.dumps().size(); ++k) {
+            const auto& d = flight.dumps()[k];
+            ext_metrics.flight_dumps.push_back(
+                FlightDumpMetrics{FlightRecorder::dump_file_name(k), d.time_ms, d.reason, d.num_events});
+        }
+    }
+    ext_metrics.peak_vram_per_gpu = sim.peak_vram_per_gpu();
+    ext_metrics.tokens_per_gpu = sim.tokens_per_gpu();
+    ext_metrics.requests_finished_per_gpu = sim.requests_finished_per_gpu();
+    bool multi_tenant = !cfg.tenants.empty() || cfg.policy.ttft_slo_ms > 0.0 || sim.tenants().size() > 1;
+    if (multi_tenant) {
+        for (const auto& t : sim.tenants()) {
+            ext_metrics.tenants.push_back(TenantMetrics{t.cfg.name, t.cfg.ttft_slo_ms, t.rate_limited, t.quota_rejected, t.slo_rejected});
+        }
+    }
+    if (!cfg.models.empty() || sim.models().size() > 1) {
+        for (const auto& m : sim.models()) {
+            ext_metrics.models.push_back(ModelMetrics{m.cfg.name, m.cfg.weights_bytes, m.cfg.kv_bytes_per_token,
+                                                      static_cast<int>(m.gpus.size()), m.swap_ins});
+        }
+    }
+    return ext_metrics;
+}
@@ -0,0 +1,35 @@
+#include "length_predictor.hpp"
+#include <algorithm>
+#include <cmath>
+#include "rng.hpp"
+
+void predict_gen_lengths(RequestTable& reqs, const PolicyConfig& policy, unsigned int seed, int replication) {
+    RNG rng = make_rng(seed, replication, RngStream::LengthPredictor, 0x9e3779b9u);
+    for (auto& r : reqs.hot) {
+        int predicted = r.gen_tokens;
+        switch (policy.length_predictor) {
+            case LengthPredictor::Oracle:
+                break;
+            case LengthPredictor::Noisy: {
+                // Median-unbiased multiplicative log-normal error
+                double factor = std::exp(policy.length_predictor_sigma * rng.normal01());
+                predicted = static_cast<int>(std::lround(r.gen_tokens * factor));
+                break;
+            }
+            case LengthPredictor::Bucketed: {
+                // Classifier over fixed-width buckets; predicts the bucket's upper edge
+                int width = std::max(1, policy.length_bucket_tokens);
+                int bucket = std::max(0, r.gen_tokens - 1) / width;
+                double u = rng.uniform01();
+                if (u < policy.length_bucket_error * 0.5) {
+                    bucket = std::max(0, bucket - 1);
+                } else if (u < policy.length_bucket_error) {
+                    bucket++;
+                }
+                predicted = (bucket + 1) * width;
+                break;
+            }
+        }
+        r.predicted_gen_tokens = std::max(1, predicted);
+    }
+}
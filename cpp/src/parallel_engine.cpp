@@ -0,0 +1,362 @@
+#include <algorithm>
+#include <condition_variable>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <thread>
+#include "simulator.hpp"
+
+// Conservative parallel engine.
+//
+// GPUs are split into contiguous partitions, one Lane each. StartPrefill, Finish,
+// KvGrow, SessionExpire and same-partition HandoffComplete only touch their own
+// GPUs, so they live in the lane queues. (A session's retained KV is only written
+// by the lane holding it; claims happen at placement, which is serial.) Everything
+// that reads cluster-wide state (arrivals and routing, decode routing, handoff
+// starts, cross-partition handoff completion, client timeouts) lives in
+// global_events_ and runs serially.
+//
+// A window [T, end) runs the lanes concurrently, where T is the earliest pending
+// event and end = min(next global event, T + lookahead). The lookahead is the
+// shortest prefill, i.e. the minimum delay before a lane event can create a global
+// event. Lanes log each handled event; the logs are then replayed in the canonical
+// (time, request, type, gpu) order, which rebuilds the event log, the counters and
+// every timeseries sample exactly as the sequential engine would.
+
+thread_local Simulator::Lane* Simulator::active_lane_ = nullptr;
+
+namespace {
+
+// Persistent workers; the calling thread always takes job 0
+class LanePool {
+public:
+    explicit LanePool(int workers) {
+        for (int i = 0; i < workers; ++i) {
+            threads_.emplace_back([this, i] { loop(i + 1); });
+        }
+    }
+
+    ~LanePool() {
+        {
+            std::lock_guard<std::mutex> lk(m_);
+            stop_ = true;
+            ++generation_;
+        }
+        cv_.notify_all();
+        for (auto& t : threads_) t.join();
+    }
+
+    void run(int n, const std::function<void(int)>& job) {
+        {
+            std::lock_guard<std::mutex> lk(m_);
+            job_ = &job;
+            jobs_ = n;
+            pending_ = n - 1;
+            ++generation_;
+        }
+        cv_.notify_all();
+        job(0);
+        std::unique_lock<std::mutex> lk(m_);
+        done_cv_.wait(lk, [this] { return pending_ == 0; });
+    }
+
+private:
+    void loop(int idx) {
+        std::uint64_t seen = 0;
+        while (true) {
+            const std::function<void(int)>* job = nullptr;
+            {
+                std::unique_lock<std::mutex> lk(m_);
+                cv_.wait(lk, [&] { return stop_ || generation_ != seen; });
+                if (stop_) return;
+                seen = generation_;
+                if (idx >= jobs_) continue;
+                job = job_;
+            }
+            (*job)(idx);
+            {
+                std::lock_guard<std::mutex> lk(m_);
+                if (--pending_ == 0) done_cv_.notify_one();
+            }
+        }
+    }
+
+    std::vector<std::thread> threads_;
+    std::mutex m_;
+    std::condition_variable cv_;
+    std::condition_variable done_cv_;
+    const std::function<void(int)>* job_ = nullptr;
+    int jobs_ = 0;
+    int pending_ = 0;
+    std::uint64_t generation_ = 0;
+    bool stop_ = false;
+};
+
+}  // namespace
+
+void Simulator::SimCounters::add(const SimCounters& o) {
+    tokens_generated += o.tokens_generated;
+    rejects += o.rejects;
+    cross_gpu_decodes += o.cross_gpu_decodes;
+    kv_growth_steps += o.kv_growth_steps;
+    kv_growth_failures += o.kv_growth_failures;
+    spec_steps += o.spec_steps;
+    spec_tokens += o.spec_tokens;
+    spec_fallbacks += o.spec_fallbacks;
+    session_followups += o.session_followups;
+    session_hits += o.session_hits;
+    session_reused_tokens += o.session_reused_tokens;
+    session_prefill_saved_ms += o.session_prefill_saved_ms;
+    session_retained += o.session_retained;
+    session_expired += o.session_expired;
+    session_pressure_drops += o.session_pressure_drops;
+    evictions += o.evictions;
+    last_request_event_ms = std::max(last_request_event_ms, o.last_request_event_ms);
+}
+
+void Simulator::push_event(const Event& e) {
+    Event stamped = e;
+    if (event_cancellable(e.type)) {
+        auto& req = requests_[e.request_index];
+        stamped.generation = req.event_generation;
+        req.pending_events++;
+    }
+    enqueue_event(stamped);
+}
+
+void Simulator::enqueue_event(const Event& e) {
+    if (!parallel_) {
+        pq_.push(e);
+        return;
+    }
+    bool global = is_global_event(e);
+    if (active_lane_) {
+        // Lane events stay in the lane; global ones are handed over after the window
+        if (global) {
+            active_lane_->outbox.push_back(e);
+        } else {
+            active_lane_->pq.push(e);
+        }
+        return;
+    }
+    if (global) {
+        global_events_.push(e);
+    } else {
+        lanes_[gpu_partition_[e.gpu_index]].pq.push(e);
+    }
+}
+
+bool Simulator::is_global_event(const Event& e) const {
+    switch (e.type) {
+        case EventType::StartPrefill:
+        case EventType::Finish:
+        case EventType::KvGrow:
+        case EventType::SessionExpire:
+            return false;
+        case EventType::HandoffComplete: {
+            int src = requests_[e.request_index].prefill_gpu;
+            return gpu_partition_[src] != gpu_partition_[e.gpu_index];
+        }
+        default:
+            return true;
+    }
+}
+
+double Simulator::parallel_lookahead_ms() const {
+    // Lane handlers create global events only via StartPrefill -> StartDecode, at the
+    // fastest GPU / model pairing. A session cache hit can cut a prefill to one token.
+    int min_prompt = std::numeric_limits<int>::max();
+    for (const auto& req : requests_.hot) min_prompt = std::min(min_prompt, req.prompt_tokens);
+    if (cfg_.policy.session_kv_ttl_ms > 0.0 && !sessions_.empty()) min_prompt = std::min(min_prompt, 1);
+    double max_tps = 0.0;
+    for (const auto& g : cfg_.gpus) max_tps = std::max(max_tps, g.prefill_tps);
+    double max_speed = 0.0;
+    for (const auto& m : models_) max_speed = std::max(max_speed, m.cfg.prefill_speed);
+    max_tps *= max_speed;
+    if (requests_.empty() || min_prompt <= 0 || max_tps <= 0.0) return 0.0;
+    return 1000.0 * min_prompt / max_tps;
+}
+
+bool Simulator::next_parallel_event(Event& out, bool& from_global) {
+    EventCompare later;
+    bool found = false;
+    auto drop_dead = [this](EventQueue& q) {
+        while (!q.empty() && event_dead(q.top())) {
+            take_event(q.top());
+            q.pop();
+        }
+    };
+    drop_dead(global_events_);
+    if (!global_events_.empty()) {
+        out = global_events_.top();
+        from_global = true;
+        found = true;
+    }
+    for (auto& lane : lanes_) {
+        drop_dead(lane.pq);
+        if (lane.pq.empty()) continue;
+        if (!found || later(out, lane.pq.top())) {
+            out = lane.pq.top();
+            from_global = false;
+            found = true;
+        }
+    }
+    return found;
+}
+
+void Simulator::run_lane_window(Lane& lane, double window_end) {
+    active_lane_ = &lane;
+    while (!lane.pq.empty() && lane.pq.top().time_ms < window_end) {
+        Event e = lane.pq.top();
+        lane.pq.pop();
+        if (!take_event(e)) continue;
+        lane.now_ms = e.time_ms;
+        lane.ctr = SimCounters{};
+        std::size_t records_begin = lane.records.size();
+        handle_event(e);
+
+        LaneStep step;
+        step.event = e;
+        step.gpus[0] = e.gpu_index;
+        step.loads[0] = load_of(e.gpu_index);
+        if (e.type == EventType::HandoffComplete) {
+            int src = requests_[e.request_index].prefill_gpu;
+            if (src != e.gpu_index) {
+                step.gpus[1] = src;
+                step.loads[1] = load_of(src);
+            }
+        }
+        step.ctr = lane.ctr;
+        step.records_begin = records_begin;
+        step.records_end = lane.records.size();
+        lane.steps.push_back(step);
+    }
+    active_lane_ = nullptr;
+}
+
+void Simulator::replay_window(std::vector<GpuLoad>& view) {
+    EventCompare later;
+    std::vector<std::size_t> cursor(lanes_.size(), 0);
+    sample_view_ = &view;
+    while (true) {
+        int pick = -1;
+        for (std::size_t l = 0; l < lanes_.size(); ++l) {
+            if (cursor[l] >= lanes_[l].steps.size()) continue;
+            if (pick < 0 || later(lanes_[pick].steps[cursor[pick]].event, lanes_[l].steps[cursor[l]].event)) {
+                pick = static_cast<int>(l);
+            }
+        }
+        if (pick < 0) break;
+        Lane& lane = lanes_[pick];
+        const LaneStep& step = lane.steps[cursor[pick]++];
+        for (int i = 0; i < 2; ++i) {
+            if (step.gpus[i] >= 0) view[step.gpus[i]] = step.loads[i];
+        }
+        ctr_.add(step.ctr);
+        for (std::size_t r = step.records_begin; r < step.records_end; ++r) {
+            log_record(std::move(lane.records[r]));
+        }
+        now_ms_ = step.event.time_ms;
+        sample_until(now_ms_);
+    }
+    sample_view_ = nullptr;
+
+    for (auto& lane : lanes_) {
+        KV_PROF(perf_.add_handlers(lane.perf));
+        KV_PROF(lane.perf = PerfStats{});
+        dead_events_ = std::max<std::int64_t>(0, dead_events_ + lane.dead_delta);
+        lane.dead_delta = 0;
+        for (const auto& e : lane.outbox) global_events_.push(e);
+        for (std::size_t t = 0; t < lane.tenant_releases.size(); ++t) {
+            auto& inflight = tenants_[t].inflight;
+            inflight = std::max(0, inflight - lane.tenant_releases[t]);
+            lane.tenant_releases[t] = 0;
+        }
+        lane.outbox.clear();
+        lane.records.clear();
+        lane.steps.clear();
+    }
+}
+
+void Simulator::run_parallel(int threads) {
+    int num_gpus = static_cast<int>(gpus_.size());
+    int parts = std::max(1, std::min(threads, num_gpus));
+    if (parts == 1) {
+        run();
+        return;
+    }
+
+    KV_PROF_TIMER(perf_.run_ns);
+    parallel_ = true;
+    lanes_.resize(parts);
+    for (auto& lane : lanes_) lane.reset(tenants_.size());
+    gpu_partition_.resize(num_gpus);
+    for (int g = 0; g < num_gpus; ++g) gpu_partition_[g] = static_cast<int>(static_cast<long long>(g) * parts / num_gpus);
+    double lookahead = parallel_lookahead_ms();
+
+    if (!started_) {
+        start_if_needed();
+    } else {
+        // Resuming (e.g. from a checkpoint): redistribute the sequential queue
+        while (!pq_.empty()) {
+            enqueue_event(pq_.top());
+            pq_.pop();
+        }
+    }
+
+    LanePool pool(parts - 1);
+    std::vector<GpuLoad> view(num_gpus);
+    std::vector<int> busy;
+    Event next;
+    bool from_global = false;
+    while (!stop_requested()) {
+        maybe_compact_events();
+        if (!next_parallel_event(next, from_global)) break;
+#ifdef KV_SIM_PROFILE
+        std::size_t pending = global_events_.size();
+        for (const auto& lane : lanes_) pending += lane.pq.size();
+        perf_.note_queue(pending);
+#endif
+        if (!from_global && global_queue_.empty() && lookahead > 0.0) {
+            double horizon = global_events_.empty() ? std::numeric_limits<double>::infinity()
+                                                    : global_events_.top().time_ms;
+            double window_end = std::min(horizon, next.time_ms + lookahead);
+            if (window_end > next.time_ms) {
+                busy.clear();
+                for (int l = 0; l < parts; ++l) {
+                    if (!lanes_[l].pq.empty() && lanes_[l].pq.top().time_ms < window_end) busy.push_back(l);
+                }
+                for (int g = 0; g < num_gpus; ++g) view[g] = load_of(g);
+                if (busy.size() == 1) {
+                    run_lane_window(lanes_[busy[0]], window_end);
+                } else {
+                    pool.run(static_cast<int>(busy.size()), [&](int i) { run_lane_window(lanes_[busy[i]], window_end); });
+                }
+                replay_window(view);
+                continue;
+            }
+        }
+
+        // Serial step in canonical order
+        if (from_global) {
+            global_events_.pop();
+        } else {
+            lanes_[gpu_partition_[next.gpu_index]].pq.pop();
+        }
+        take_event(next);
+        now_ms_ = next.time_ms;
+        handle_event(next);
+        if (next.type != EventType::TimerTick) sample_until(now_ms_);
+    }
+
+    if (stop_requested()) {
+        // Cancelled: hand the pending events back to the sequential queue
+        for (auto& lane : lanes_) {
+            for (; !lane.pq.empty(); lane.pq.pop()) pq_.push(lane.pq.top());
+        }
+        for (; !global_events_.empty(); global_events_.pop()) pq_.push(global_events_.top());
+    }
+    parallel_ = false;
+    lanes_.clear();
+    report_totals();
+}
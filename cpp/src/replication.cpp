@@ -0,0 +1,200 @@
+#include "replication.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include "io_output.hpp"
+#include "simulator.hpp"
+
+namespace {
+
+ReplicationSample summarize(const Simulator& sim) {
+    SummaryMetrics m = compute_summary_metrics(sim.requests(), sim.samples(), sim.tokens_generated_total(),
+                                               sim.sim_end_ms(), sim.evictions());
+    return ReplicationSample{m.p50_latency_ms, m.p99_latency_ms, m.throughput_tokens_per_sec, m.reject_rate};
+}
+
+// Acklam's rational approximation of the standard normal quantile
+double normal_quantile(double p) {
+    static const double a[] = {-3.969683028665376e+01, 2.209460984245205e+02, -2.759285104469687e+02,
+                               1.383577518672690e+02, -3.066479806614716e+01, 2.506628277459239e+00};
+    static const double b[] = {-5.447609879822406e+01, 1.615858368580409e+02, -1.556989798598866e+02,
+                               6.680131188771972e+01, -1.328068155288572e+01};
+    static const double c[] = {-7.784894002430293e-03, -3.223964580411365e-01, -2.400758277161838e+00,
+                               -2.549732539343734e+00, 4.374664141464968e+00, 2.938163982698783e+00};
+    static const double d[] = {7.784695709041462e-03, 3.224671290700398e-01, 2.445134137142996e+00,
+                               3.754408661907416e+00};
+    const double p_low = 0.02425;
+    if (p < p_low) {
+        double q = std::sqrt(-2.0 * std::log(p));
+        return (((((c[0] * q + c[1]) * q + c[2]) * q + c[3]) * q + c[4]) * q + c[5]) /
+               ((((d[0] * q + d[1]) * q + d[2]) * q + d[3]) * q + 1.0);
+    }
+    if (p > 1.0 - p_low) return -normal_quantile(1.0 - p);
+    double q = p - 0.5;
+    double r = q * q;
+    return (((((a[0] * r + a[1]) * r + a[2]) * r + a[3]) * r + a[4]) * r + a[5]) * q /
+           (((((b[0] * r + b[1]) * r + b[2]) * r + b[3]) * r + b[4]) * r + 1.0);
+}
+
+// Regularized incomplete beta I_x(a, b), by Lentz's continued fraction
+double incomplete_beta(double x, double a, double b) {
+    if (x <= 0.0) return 0.0;
+    if (x >= 1.0) return 1.0;
+    // The fraction converges fast only below the mean; use the symmetry otherwise
+    if (x > (a + 1.0) / (a + b + 2.0)) return 1.0 - incomplete_beta(1.0 - x, b, a);
+    const double tiny = 1e-300;
+    double front = std::exp(std::lgamma(a + b) - std::lgamma(a) - std::lgamma(b) + a * std::log(x) +
+                            b * std::log1p(-x)) / a;
+    double f = 1.0, c = 1.0, d = 0.0;
+    for (int i = 0; i <= 400; ++i) {
+        int m = i / 2;
+        double num;
+        if (i == 0) {
+            num = 1.0;
+        } else if (i % 2 == 0) {
+            num = (m * (b - m) * x) / ((a + 2.0 * m - 1.0) * (a + 2.0 * m));
+        } else {
+            num = -((a + m) * (a + b + m) * x) / ((a + 2.0 * m) * (a + 2.0 * m + 1.0));
+        }
+        d = 1.0 + num * d;
+        if (std::fabs(d) < tiny) d = tiny;
+        d = 1.0 / d;
+        c = 1.0 + num / c;
+        if (std::fabs(c) < tiny) c = tiny;
+        double cd = c * d;
+        f *= cd;
+        if (std::fabs(1.0 - cd) < 1e-15) break;
+    }
+    return front * (f - 1.0);
+}
+
+// P(T > t) for Student's t with v degrees of freedom, t >= 0
+double student_t_upper_tail(double t, double v) { return 0.5 * incomplete_beta(v / (v + t * t), v / 2.0, 0.5); }
+
+std::vector<MetricEstimate> estimate(const std::vector<ReplicationSample>& samples, int n, double level) {
+    std::vector<MetricEstimate> out = {
+        {"p50_latency_ms", 0.0, 0.0, 0.0},
+        {"p99_latency_ms", 0.0, 0.0, 0.0},
+        {"throughput_tokens_per_sec", 0.0, 0.0, 0.0},
+        {"reject_rate", 0.0, 0.0, 0.0},
+    };
+    if (n <= 0) return out;
+    auto value = [&](int i, std::size_t m) {
+        const auto& s = samples[i];
+        switch (m) {
+            case 0: return s.p50_latency_ms;
+            case 1: return s.p99_latency_ms;
+            case 2: return s.throughput_tokens_per_sec;
+            default: return s.reject_rate;
+        }
+    };
+    double t = (n > 1) ? student_t_critical(level, n - 1) : 0.0;
+    for (std::size_t m = 0; m < out.size(); ++m) {
+        double sum = 0.0;
+        for (int i = 0; i < n; ++i) sum += value(i, m);
+        double mean = sum / n;
+        double ss = 0.0;
+        for (int i = 0; i < n; ++i) ss += (value(i, m) - mean) * (value(i, m) - mean);
+        out[m].mean = mean;
+        out[m].stddev = (n > 1) ? std::sqrt(ss / (n - 1)) : 0.0;
+        out[m].half_width = t * out[m].stddev / std::sqrt(static_cast<double>(n));
+    }
+    return out;
+}
+
+bool within_target(const std::vector<MetricEstimate>& est, double target) {
+    for (const auto& e : est) {
+        if (e.half_width > target * std::fabs(e.mean)) return false;
+    }
+    return true;
+}
+
+}  // namespace
+
+double student_t_critical(double level, int dof) {
+    // Exact quantile: bisect the upper tail, which falls monotonically in t. The normal
+    // quantile is a lower bound to start from.
+    double v = static_cast<double>(std::max(dof, 1));
+    double tail = (1.0 - level) / 2.0;
+    double lo = std::max(0.0, normal_quantile(1.0 - tail));
+    double hi = std::max(1.0, 2.0 * lo);
+    while (student_t_upper_tail(hi, v) > tail && hi < 1e12) hi *= 2.0;
+    for (int i = 0; i < 200 && hi - lo > 1e-12 * hi; ++i) {
+        double mid = 0.5 * (lo + hi);
+        if (student_t_upper_tail(mid, v) > tail) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+    return 0.5 * (lo + hi);
+}
+
+bool run_replications(const SimConfig& cfg, const std::vector<Request>& requests,
+                      const ReplicationOptions& opts, ReplicationResult& result, std::string& err) {
+    if (opts.max_replications < 1) {
+        err = "replications must be >= 1";
+        return false;
+    }
+    if (opts.ci_level <= 0.0 || opts.ci_level >= 1.0) {
+        err = "ci_level must be in (0, 1)";
+        return false;
+    }
+    int max_reps = opts.max_replications;
+    int min_reps = std::max(2, std::min(opts.min_replications, max_reps));
+
+    std::vector<ReplicationSample> samples(max_reps);
+    std::vector<char> done(max_reps, 0);
+    std::atomic<int> next{0};
+    std::mutex mu;
+    int prefix = 0;        // replications [0, prefix) are complete
+    int stop_at = max_reps;
+
+    auto worker = [&]() {
+        std::unique_ptr<Simulator> sim;  // one per worker, reset between replications
+        while (true) {
+            int i = next.fetch_add(1);
+            {
+                std::lock_guard<std::mutex> lk(mu);
+                if (i >= stop_at) return;
+            }
+            SimConfig rep_cfg = cfg;
+            rep_cfg.replication = i;
+            if (sim) {
+                sim->reset(rep_cfg, requests);
+            } else {
+                sim = std::make_unique<Simulator>(rep_cfg, requests);
+                sim->set_verbose(false);
+            }
+            sim->run();
+            ReplicationSample s = summarize(*sim);
+
+            std::lock_guard<std::mutex> lk(mu);
+            samples[i] = s;
+            done[i] = 1;
+            // Stop rule only ever sees complete prefixes, in index order
+            while (prefix < stop_at && done[prefix]) {
+                prefix++;
+                if (opts.ci_target > 0.0 && prefix >= min_reps &&
+                    within_target(estimate(samples, prefix, opts.ci_level), opts.ci_target)) {
+                    stop_at = prefix;
+                }
+            }
+        }
+    };
+
+    int threads = std::max(1, std::min(opts.threads, max_reps));
+    std::vector<std::thread> pool;
+    for (int t = 1; t < threads; ++t) pool.emplace_back(worker);
+    worker();
+    for (auto& th : pool) th.join();
+
+    samples.resize(stop_at);
+    result.estimates = estimate(samples, stop_at, opts.ci_level);
+    result.converged = opts.ci_target > 0.0 && stop_at >= min_reps && within_target(result.estimates, opts.ci_target);
+    result.samples = std::move(samples);
+    return true;
+}
@@ -0,0 +1,273 @@
+#include "result_cache.hpp"
+#include <dlfcn.h>
+#include <atomic>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+#ifndef KV_SIM_VERSION
+#define KV_SIM_VERSION "dev"
+#endif
+
+namespace {
+
+const char* const kCachedFiles[] = {"summary.json", "timeseries.csv", "events.jsonl"};
+
+// The fixed outputs plus the flight-recorder dumps listed in dir's summary.json
+std::vector<std::string> output_files(const std::string& dir) {
+    std::vector<std::string> names(std::begin(kCachedFiles), std::end(kCachedFiles));
+    std::ifstream f(dir + "/summary.json");
+    std::string text((std::istreambuf_iterator<char>(f)), std::istreambuf_iterator<char>());
+    const std::string tag = "{\"file\": \"";
+    for (auto pos = text.find(tag); pos != std::string::npos; pos = text.find(tag, pos)) {
+        pos += tag.size();
+        auto end = text.find('"', pos);
+        if (end == std::string::npos) break;
+        std::string name = text.substr(pos, end - pos);
+        if (!name.empty() && name.find('/') == std::string::npos) names.push_back(std::move(name));
+    }
+    return names;
+}
+
+class Fnv1a {
+public:
+    void bytes(const void* p, std::size_t n) {
+        const auto* b = static_cast<const unsigned char*>(p);
+        for (std::size_t i = 0; i < n; ++i) {
+            h_ ^= b[i];
+            h_ *= 1099511628211ull;
+        }
+    }
+    void u64(std::uint64_t v) { bytes(&v, sizeof(v)); }
+    void i64(std::int64_t v) { bytes(&v, sizeof(v)); }
+    void f64(double v) {
+        if (v == 0.0) v = 0.0;  // -0.0 and 0.0 behave the same
+        bytes(&v, sizeof(v));
+    }
+    void str(const std::string& s) {
+        u64(s.size());
+        bytes(s.data(), s.size());
+    }
+    std::uint64_t value() const { return h_; }
+
+private:
+    std::uint64_t h_ = 1469598103934665603ull;
+};
+
+std::string hex16(std::uint64_t v) {
+    char buf[17];
+    std::snprintf(buf, sizeof(buf), "%016llx", static_cast<unsigned long long>(v));
+    return buf;
+}
+
+std::uint64_t hash_file(const std::string& path) {
+    std::ifstream f(path, std::ios::binary);
+    if (!f.is_open()) return 0;
+    Fnv1a h;
+    char buf[65536];
+    while (f.read(buf, sizeof(buf)) || f.gcount()) h.bytes(buf, static_cast<std::size_t>(f.gcount()));
+    return h.value();
+}
+
+}  // namespace
+
+const std::string& kv_sim_build_id() {
+    static const std::string id = [] {
+        // The object this function lives in: the kv_sim executable, or the shared
+        // library / Python module that linked kv_sim_core
+        Dl_info info{};
+        std::string path;
+        if (dladdr(reinterpret_cast<void*>(&hash_config), &info) && info.dli_fname) path = info.dli_fname;
+        std::error_code ec;
+        if (path.empty() || !fs::exists(path, ec)) path = "/proc/self/exe";
+        return std::string(KV_SIM_VERSION) + "-" + hex16(hash_file(path));
+    }();
+    return id;
+}
+
+std::uint64_t hash_config(const SimConfig& cfg) {
+    // Every field that can change a run. Keep in sync with SimConfig.
+    Fnv1a h;
+    h.u64(cfg.gpus.size());
+    for (const auto& g : cfg.gpus) {
+        h.u64(g.vram_bytes);
+        h.i64(g.max_concurrent);
+        h.f64(g.prefill_tps);
+        h.f64(g.decode_tps);
+        h.i64(g.decode_sharing_cap);
+        h.f64(g.decode_efficiency);
+        h.u64(g.models.size());
+        for (const auto& m : g.models) h.str(m);
+    }
+    for (const auto* m : {&cfg.latency_matrix, &cfg.bandwidth_matrix}) {
+        h.u64(m->size());
+        for (const auto& row : *m) {
+            h.u64(row.size());
+            for (double v : row) h.f64(v);
+        }
+    }
+    h.u64(cfg.raw_links.size());
+    for (const auto& l : cfg.raw_links) {
+        h.i64(l.src);
+        h.i64(l.dest);
+        h.f64(l.bandwidth_gbps);
+        h.f64(l.latency_ms);
+    }
+    h.i64(cfg.hierarchy.gpus_per_node);
+    h.i64(cfg.hierarchy.nodes_per_rack);
+    for (const auto* l : {&cfg.hierarchy.node, &cfg.hierarchy.rack, &cfg.hierarchy.cluster}) {
+        h.f64(l->bandwidth_gbps);
+        h.f64(l->latency_ms);
+    }
+    h.u64(cfg.tenants.size());
+    for (const auto& t : cfg.tenants) {
+        h.str(t.name);
+        h.f64(t.rate_rps);
+        h.f64(t.burst);
+        h.i64(t.max_inflight);
+        h.f64(t.ttft_slo_ms);
+    }
+    h.u64(cfg.models.size());
+    for (const auto& m : cfg.models) {
+        h.str(m.name);
+        h.u64(m.weights_bytes);
+        h.u64(m.kv_bytes_per_token);
+        h.f64(m.prefill_speed);
+        h.f64(m.decode_speed);
+        h.f64(m.swap_in_ms);
+    }
+    h.i64(static_cast<int>(cfg.model_loading));
+
+    const auto& p = cfg.policy;
+    h.i64(p.safe_reservation);
+    h.i64(p.max_queue);
+    h.u64(p.kv_bytes_per_token);
+    h.i64(p.max_admission_retries);
+    h.f64(p.handoff_latency_us);
+    h.f64(p.handoff_bandwidth_gbps);
+    h.f64(p.handoff_cost_weight);
+    h.i64(static_cast<int>(p.handoff_mode));
+    h.i64(p.handoff_layers);
+    h.i64(p.handoff_chunk_layers);
+    h.i64(static_cast<int>(p.scheduling));
+    h.i64(static_cast<int>(p.memory_pressure_policy));
+    h.i64(static_cast<int>(p.eviction_policy));
+    h.i64(static_cast<int>(p.routing_policy));
+    h.i64(static_cast<int>(p.global_dispatch));
+    h.f64(p.global_aging_ms);
+    h.u64(p.class_weights.size());
+    for (double w : p.class_weights) h.f64(w);
+    h.f64(p.ttft_slo_ms);
+    h.i64(p.slo_admission);
+    h.i64(static_cast<int>(p.length_predictor));
+    h.f64(p.length_predictor_sigma);
+    h.i64(p.length_bucket_tokens);
+    h.f64(p.length_bucket_error);
+    h.i64(p.predicted_reservation);
+    h.i64(p.kv_growth_chunk_tokens);
+    h.f64(p.session_kv_ttl_ms);
+    h.f64(p.session_affinity_weight);
+    const auto& s = p.spec_decode;
+    h.i64(s.enabled);
+    h.i64(s.draft_len);
+    h.f64(s.acceptance);
+    h.i64(static_cast<int>(s.acceptance_dist));
+    h.f64(s.acceptance_spread);
+    h.f64(s.acceptance_concentration);
+    h.f64(s.draft_cost);
+    h.f64(s.verify_cost);
+    h.u64(s.draft_kv_bytes_per_token);
+    h.i64(static_cast<int>(s.placement));
+    h.f64(s.remote_latency_ms);
+    h.f64(p.request_timeout_ms);
+    h.u64(p.class_timeouts_ms.size());
+    for (double t : p.class_timeouts_ms) h.f64(t);
+    h.u64(p.vram_bytes);
+    h.f64(p.prefill_tps);
+    h.f64(p.decode_tps);
+
+    h.f64(cfg.timeseries_dt_ms);
+    h.i64(cfg.flight.events);
+    h.i64(cfg.flight.rejects_delta);
+    h.i64(cfg.flight.queue_depth);
+    h.f64(cfg.flight.p99_ttft_ms);
+    h.i64(cfg.flight.p99_window);
+    h.i64(cfg.flight.max_dumps);
+    h.i64(cfg.replication);
+    return h.value();
+}
+
+std::uint64_t hash_trace(const std::vector<Request>& requests) {
+    // Every trace column; keep in sync with Request
+    Fnv1a h;
+    h.u64(requests.size());
+    for (const auto& r : requests) {
+        h.str(r.id);
+        h.f64(r.arrival_time_ms);
+        h.i64(r.prompt_tokens);
+        h.i64(r.gen_tokens);
+        h.i64(r.streaming);
+        h.i64(r.priority);
+        h.str(r.tenant);
+        h.str(r.model);
+        h.str(r.session);
+        h.i64(r.turn);
+        h.f64(r.timeout_ms);
+    }
+    return h.value();
+}
+
+std::string cache_key(const SimConfig& cfg, const std::vector<Request>& requests) {
+    return kv_sim_build_id() + "-t" + hex16(hash_trace(requests)) + "-c" + hex16(hash_config(cfg)) + "-s" +
+           std::to_string(cfg.seed);
+}
+
+bool ResultCache::fetch(const std::string& key, const std::string& out_dir) const {
+    std::error_code ec;
+    std::string entry = entry_dir(key);
+    if (!fs::is_directory(entry, ec)) return false;
+    fs::create_directories(out_dir, ec);
+    if (ec) return false;
+    for (const auto& name : output_files(entry)) {
+        fs::copy_file(entry + "/" + name, out_dir + "/" + name, fs::copy_options::overwrite_existing, ec);
+        if (ec) return false;
+    }
+    return true;
+}
+
+bool ResultCache::store(const std::string& key, const std::string& out_dir, std::string& err) const {
+    static std::atomic<unsigned> counter{0};
+    std::error_code ec;
+    std::string entry = entry_dir(key);
+    if (fs::is_directory(entry, ec)) return true;
+    fs::create_directories(dir_, ec);
+    if (ec) {
+        err = "cannot create cache dir " + dir_ + ": " + ec.message();
+        return false;
+    }
+    // Fill a private staging dir, then publish it with a single rename
+    std::string tmp = dir_ + "/.tmp-" + std::to_string(getpid()) + "-" + std::to_string(counter++) + "-" + key;
+    fs::create_directories(tmp, ec);
+    for (const auto& name : output_files(out_dir)) {
+        if (!ec) fs::copy_file(out_dir + "/" + name, tmp + "/" + name, fs::copy_options::overwrite_existing, ec);
+    }
+    if (ec) {
+        err = "cannot stage cache entry: " + ec.message();
+        fs::remove_all(tmp, ec);
+        return false;
+    }
+    fs::rename(tmp, entry, ec);
+    if (ec) {
+        // Lost a race with another writer of the same key; its entry is identical
+        fs::remove_all(tmp, ec);
+        if (!fs::is_directory(entry, ec)) {
+            err = "cannot publish cache entry " + entry;
+            return false;
+        }
+    }
+    return true;
+}
@@ -1,9 +1,18 @@
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
 #include <iostream>
+#include <memory>
 #include <unordered_map>
+#include "kv_sim.hpp"
 #include "simulator.hpp"
 #include "io_config.hpp"
 #include "io_trace.hpp"
 #include "io_output.hpp"
+#include "replication.hpp"
+#include "result_cache.hpp"
+#include "trace_export.hpp"
 
 static std::unordered_map<std::string, std::string> parse_args(int argc, char** argv) {
     std::unordered_map<std::string, std::string> m;
@@ -51,26 +60,113 @@ int main(int argc, char** argv) {
         reqs.push_back(Request{"req2", 50.0, 150, 300, false});
     }
 
-    Simulator sim(cfg, std::move(reqs));
-    sim.run();
+    int threads = args.count("--threads") ? std::stoi(args["--threads"]) : 1;
 
-    // Phase 8: Populate extended metrics from simulator
-    ExtendedMetrics ext_metrics;
-    ext_metrics.retry_attempts = sim.retry_attempts();
-    ext_metrics.retry_successes = sim.retry_successes();
-    ext_metrics.handoffs_total = sim.handoffs_total();
-    ext_metrics.cross_gpu_decodes = sim.cross_gpu_decodes();
-    ext_metrics.max_global_queue_depth = sim.max_global_queue_depth();
-    ext_metrics.peak_vram_per_gpu = sim.peak_vram_per_gpu();
-    ext_metrics.tokens_per_gpu = sim.tokens_per_gpu();
-    ext_metrics.requests_finished_per_gpu = sim.requests_finished_per_gpu();
+    // Monte Carlo mode: independent replications aggregated into confidence intervals
+    if (args.count("--replications")) {
+        ReplicationOptions opts;
+        opts.max_replications = std::stoi(args["--replications"]);
+        opts.threads = threads;
+        if (args.count("--min-replications")) opts.min_replications = std::stoi(args["--min-replications"]);
+        if (args.count("--ci-level")) opts.ci_level = std::stod(args["--ci-level"]);
+        if (args.count("--ci-target")) opts.ci_target = std::stod(args["--ci-target"]);
+        ReplicationResult result;
+        if (!run_replications(cfg, reqs, opts, result, err)) {
+            std::cerr << "replication error: " << err << "\n";
+            return 1;
+        }
+        std::cout << "Replications: " << result.samples.size()
+                  << (result.converged ? " (converged)" : "") << '\n';
+        for (const auto& e : result.estimates) {
+            std::cout << "  " << e.name << ": " << e.mean << " +/- " << e.half_width << '\n';
+        }
+        if (!write_replications_json(out_dir, opts, result, err)) std::cerr << "write_replications error: " << err << "\n";
+        if (!write_run_meta(out_dir, cfg, err, config_path)) std::cerr << "write_run_meta error: " << err << "\n";
+        return 0;
+    }
+
+    // Result cache: a run with the same trace, effective config, seed and build is copied
+    // from disk instead of simulated. Warm starts and trace exports are never cached.
+    std::string cache_dir = args.count("--cache-dir") ? args["--cache-dir"] : "";
+    if (cache_dir.empty() && std::getenv("KV_SIM_CACHE_DIR")) cache_dir = std::getenv("KV_SIM_CACHE_DIR");
+    bool use_cache = !cache_dir.empty() && !args.count("--no-cache") && !args.count("--restore") &&
+                     !args.count("--checkpoint-at") && !args.count("--chrome-trace");
+    ResultCache cache(cache_dir);
+    std::string key;
+    if (use_cache) {
+        key = cache_key(cfg, reqs);
+        if (cache.fetch(key, out_dir)) {
+            std::cout << "Cache hit: " << key << '\n';
+            if (!write_run_meta(out_dir, cfg, err, config_path)) std::cerr << "write_run_meta error: " << err << "\n";
+            return 0;
+        }
+    }
+
+    SimSession session(cfg, std::move(reqs));
+    session.set_verbose(true);
+    Simulator& sim = session.simulator();
+    // Flight-recorder dumps land next to the other outputs as they happen
+    sim.flight_recorder().set_dump_dir(out_dir);
 
-    if (!write_summary(out_dir, sim.requests(), sim.samples(), sim.tokens_generated_total(), sim.sim_end_ms(), sim.events(), cfg, ext_metrics, err)){
-        std::cerr << "write_summary error: " << err << "\n";
+    // Warm start: resume from a snapshot, possibly under different policy settings
+    if (args.count("--restore")) {
+        if (!sim.load_checkpoint(args["--restore"], err)) {
+            std::cerr << "restore error: " << err << "\n";
+            return 1;
+        }
+    }
+    // Chrome trace-event timeline for ui.perfetto.dev (default <out>/trace.json), streamed
+    // while the run executes so it is complete even with the flight recorder on
+    std::string chrome_path;
+    std::ofstream chrome_os;
+    std::unique_ptr<ChromeTraceWriter> chrome;
+    if (args.count("--chrome-trace")) {
+        chrome_path = args["--chrome-trace"].empty() ? out_dir + "/trace.json" : args["--chrome-trace"];
+        std::error_code ec;
+        std::filesystem::create_directories(std::filesystem::path(chrome_path).parent_path(), ec);
+        chrome_os.open(chrome_path);
+        if (!chrome_os.is_open()) {
+            std::cerr << "chrome trace error: cannot open chrome trace " << chrome_path << "\n";
+        } else {
+            if (args.count("--restore") && cfg.flight.events > 0) {
+                std::cerr << "chrome trace: flight_recorder kept only the last " << cfg.flight.events
+                          << " records before the checkpoint\n";
+            }
+            chrome = std::make_unique<ChromeTraceWriter>(chrome_os, sim.num_gpus());
+            sim.set_trace_writer(chrome.get());
+        }
+    }
+    if (args.count("--checkpoint-at") && args.count("--checkpoint-out")) {
+        sim.run_until(std::stod(args["--checkpoint-at"]));
+        if (!sim.save_checkpoint(args["--checkpoint-out"], err)) {
+            std::cerr << "checkpoint error: " << err << "\n";
+            return 1;
+        }
+        std::cout << "Checkpoint at " << sim.now_ms() << " ms -> " << args["--checkpoint-out"] << '\n';
+        if (args.count("--checkpoint-exit")) return 0;
+    }
+    session.run(threads);
+
+#ifdef KV_SIM_PROFILE
+    auto output_start = std::chrono::steady_clock::now();
+#endif
+    if (!session.write_outputs(out_dir, err, config_path)) {
+        std::cerr << "write error: " << err << "\n";
+    } else if (use_cache && !cache.store(key, out_dir, err)) {
+        std::cerr << "cache error: " << err << "\n";
+    }
+    if (chrome) {
+        sim.set_trace_writer(nullptr);
+        chrome->finish();
+        chrome_os.flush();
+        if (!chrome_os) std::cerr << "chrome trace error: failed writing chrome trace " << chrome_path << "\n";
     }
-    if (!write_timeseries_csv(out_dir, sim.samples(), sim.num_gpus(), err)) std::cerr << "write_timeseries error: " << err << "\n";
-    if (!write_events_jsonl(out_dir, sim.events(), err)) std::cerr << "write_events error: " << err << "\n";
-    if (!write_run_meta(out_dir, cfg, err, config_path)) std::cerr << "write_run_meta error: " << err << "\n";
+#ifdef KV_SIM_PROFILE
+    PerfStats perf = sim.perf_stats();
+    perf.output_ns = static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - output_start).count());
+    if (!write_perf_json(out_dir, perf, err)) std::cerr << "write_perf error: " << err << "\n";
+#endif
 
     return 0;
 }
\ No newline at end of file
@@ -2,57 +2,353 @@
 #include <algorithm>
 #include <random>
 #include <limits>
+#include <cmath>
+#include <unordered_map>
 #include "simulator.hpp"
+#include "length_predictor.hpp"
+#include "trace_export.hpp"
 
 Simulator::Simulator(SimConfig cfg, std::vector<Request> requests)
-    : cfg_(std::move(cfg)),
-      requests_(std::move(requests)),
-      next_sample_ms_(cfg_.timeseries_dt_ms),
-      rng_(cfg_.seed) {
-        if (cfg_.gpus.size() == 0){
-            cfg_.gpus.push_back(GPUConfig{});
-        }
-        gpus_.resize(cfg_.gpus.size());
-        precompute_topology();
-        for (auto& gpu : gpus_) {
-            gpu.vram_used = 0;
-            gpu.active_prefill = 0;
-            gpu.active_decode = 0;
-            gpu.prefill_queue.clear();
-            gpu.evict_queue.clear();
-            gpu.lru_list.clear();
-            gpu.allocated_bytes.assign(requests_.size(), 0);
-            gpu.lru_iters.assign(requests_.size(), gpu.lru_list.end());
-        }
-        // Phase 8: Initialize per-GPU tracking vectors
-        int num_gpus = static_cast<int>(gpus_.size());
-        peak_vram_per_gpu_.assign(num_gpus, 0);
-        tokens_per_gpu_.assign(num_gpus, 0);
-        requests_finished_per_gpu_.assign(num_gpus, 0);
-      }
+    : rng_(make_rng(cfg.seed, cfg.replication, RngStream::Routing, 0u)) {
+    reset(std::move(cfg), requests);
+}
+
+void Simulator::reset(SimConfig cfg, const std::vector<Request>& requests) {
+    // Everything is cleared in place so the previous run's capacity carries over
+    cfg_ = std::move(cfg);
+    requests_.assign(requests);
+    rng_ = make_rng(cfg_.seed, cfg_.replication, RngStream::Routing, 0u);
+    if (cfg_.gpus.size() == 0){
+        cfg_.gpus.push_back(GPUConfig{});
+    }
+    gpus_.resize(cfg_.gpus.size());
+    precompute_topology();
+    for (auto& gpu : gpus_) {
+        gpu.vram_used = 0;
+        gpu.active_prefill = 0;
+        gpu.active_decode = 0;
+        gpu.prefill_queue.reset(requests_.size());
+        gpu.evict_queue.clear();
+        gpu.lru_list.clear();
+        gpu.retained_sessions.clear();
+        gpu.retained_bytes = 0;
+        gpu.arena->release();
+        gpu.allocated_bytes.assign(requests_.size(), 0);
+        gpu.lru_iters.assign(requests_.size(), gpu.lru_list.end());
+        gpu.wfq_virtual_time = 0.0;
+        gpu.wfq_last_finish.clear();
+        gpu.queued_prompt_tokens = 0;
+    }
+    pq_.clear();
+    events_.clear();
+    flight_.reset(cfg_.flight);
+    trace_writer_ = nullptr;
+    samples_.clear();
+    global_queue_.clear();
+    started_ = false;
+    now_ms_ = 0.0;
+    next_sample_ms_ = cfg_.timeseries_dt_ms;
+    dead_events_ = 0;
+    sim_end_ms_ = 0.0;
+    ctr_ = SimCounters{};
+    perf_ = PerfStats{};
+    last_tokens_sampled_ = 0;
+    last_rejects_sampled_ = 0;
+    retry_attempts_ = 0;
+    retry_successes_ = 0;
+    handoffs_total_ = 0;
+    handoffs_pipelined_ = 0;
+    handoff_whole_ms_ = 0.0;
+    handoff_exposed_ms_ = 0.0;
+    max_global_queue_depth_ = 0;
+    global_backfills_ = 0;
+    abandoned_queued_ = 0;
+    abandoned_prefill_ = 0;
+    abandoned_decode_ = 0;
+    abandoned_prefill_ms_ = 0.0;
+    abandoned_decode_tokens_ = 0.0;
+    parallel_ = false;
+    global_events_.clear();
+    sample_view_ = nullptr;
+
+    predict_gen_lengths(requests_, cfg_.policy, cfg_.seed, cfg_.replication);
+    init_tenants(requests);
+    init_spec_acceptance();
+    // Phase 8: Initialize per-GPU tracking vectors
+    int num_gpus = static_cast<int>(gpus_.size());
+    peak_vram_per_gpu_.assign(num_gpus, 0);
+    tokens_per_gpu_.assign(num_gpus, 0);
+    requests_finished_per_gpu_.assign(num_gpus, 0);
+    init_models(requests);
+    init_sessions(requests);
+    init_timeouts();
+}
 
 void Simulator::run() {
+    run_until(std::numeric_limits<double>::infinity());
+    report_totals();
+}
+
+void Simulator::report_totals() {
+    int finished{0}, rejected{0}, evicted{0}, abandoned{0};
+    for (const auto& req : requests_.hot) {
+        if (req.state == RequestState::Finished) finished++;
+        if (req.state == RequestState::Rejected) rejected++;
+        if (req.state == RequestState::Evicted) evicted++;
+        if (req.state == RequestState::Abandoned) abandoned++;
+    }
+    if (verbose_) {
+        std::cout << "Finished: " << finished
+                  << ", Rejected: " << rejected
+                  << ", Evicted: " << evicted;
+        if (timers_.enabled()) std::cout << ", Abandoned: " << abandoned;
+        std::cout << '\n';
+    }
+    // Expiries of retained session KV and timeout wake-ups after the last request left
+    // don't extend the run
+    bool quiet_tail = ctr_.session_retained > 0 || timers_.enabled();
+    sim_end_ms_ = quiet_tail ? ctr_.last_request_event_ms : now_ms_;
+}
+
+void Simulator::run_until(double t_ms) {
+    KV_PROF_TIMER(perf_.run_ns);
+    start_if_needed();
+    while (!pq_.empty() && pq_.top().time_ms <= t_ms && !stop_requested()) {
+        process_next_event();
+    }
+}
+
+std::size_t Simulator::run_for(std::size_t max_events) {
+    KV_PROF_TIMER(perf_.run_ns);
+    start_if_needed();
+    std::size_t n = 0;
+    while (n < max_events && !pq_.empty() && !stop_requested()) {
+        if (process_next_event()) ++n;
+    }
+    return n;
+}
+
+void Simulator::start_if_needed() {
+    if (started_) return;
     schedule_arrivals();
     sample_until(0.0);
+    started_ = true;
+}
+
+bool Simulator::process_next_event() {
+    maybe_compact_events();
+    if (pq_.empty()) return false;
+    Event event = pq_.top();
+    pq_.pop();
+    if (!take_event(event)) return false;
+    KV_PROF(perf_.note_queue(pq_.size() + 1));
+    now_ms_ = event.time_ms;
+    handle_event(event);
+    // Wake-ups only queue Abandon events, which sample when they run
+    if (event.type != EventType::TimerTick) sample_until(now_ms_);
+    return true;
+}
 
-    while (!pq_.empty()) {
-        Event event = pq_.top();
-        pq_.pop();
-        now_ms_ = event.time_ms;
-        handle_event(event);
-        sample_until(now_ms_);
+bool Simulator::take_event(const Event& e) {
+    if (event_dead(e)) {
+        note_dead_events(-1);
+        KV_PROF(perf().dead_events_skipped++);
+        return false;
     }
+    if (event_cancellable(e.type)) requests_[e.request_index].pending_events--;
+    return true;
+}
 
-    int finished{0}, rejected{0}, evicted{0};
-    for (const auto& req : requests_) {
-        if (req.state == RequestState::Finished) finished++;
-        if (req.state == RequestState::Rejected) rejected++;
-        if (req.state == RequestState::Evicted) evicted++;
+void Simulator::cancel_pending_events(int req_idx) {
+    auto& req = requests_[req_idx];
+    req.event_generation++;
+    if (req.pending_events == 0) return;
+    KV_PROF(perf().events_cancelled += static_cast<std::uint64_t>(req.pending_events));
+    note_dead_events(req.pending_events);
+    req.pending_events = 0;
+}
+
+void Simulator::note_dead_events(std::int64_t delta) {
+    if (active_lane_) {
+        active_lane_->dead_delta += delta;
+    } else {
+        dead_events_ = std::max<std::int64_t>(0, dead_events_ + delta);
+    }
+}
+
+void Simulator::maybe_compact_events() {
+    // Compact once at least half of a non-trivial queue is dead
+    constexpr std::int64_t kMinQueued = 1024;
+    if (dead_events_ * 2 < kMinQueued) return;
+    std::size_t queued = pq_.size() + global_events_.size();
+    for (const auto& lane : lanes_) queued += lane.pq.size();
+    if (static_cast<std::size_t>(dead_events_) * 2 < queued) return;
+    auto dead = [this](const Event& e) { return event_dead(e); };
+    std::size_t removed = pq_.compact(dead) + global_events_.compact(dead);
+    for (auto& lane : lanes_) removed += lane.pq.compact(dead);
+    dead_events_ = 0;
+    KV_PROF(perf_.heap_compactions++);
+    KV_PROF(perf_.dead_events_compacted += removed);
+}
+
+void Simulator::init_tenants(const std::vector<Request>& trace) {
+    // Index 0 is the default tenant for requests without a tenant column
+    tenants_.clear();
+    TenantConfig default_cfg;
+    default_cfg.name = "default";
+    for (const auto& t : cfg_.tenants) {
+        if (t.name == "default") default_cfg = t;
+    }
+    std::unordered_map<std::string, int> index;
+    auto add_tenant = [&](const TenantConfig& tc) {
+        TenantState ts;
+        ts.cfg = tc;
+        if (ts.cfg.ttft_slo_ms <= 0.0) ts.cfg.ttft_slo_ms = cfg_.policy.ttft_slo_ms;
+        if (ts.cfg.burst <= 0.0) ts.cfg.burst = std::max(1.0, ts.cfg.rate_rps);
+        ts.bucket_tokens = ts.cfg.burst;
+        index[tc.name] = static_cast<int>(tenants_.size());
+        tenants_.push_back(ts);
+    };
+    add_tenant(default_cfg);
+    for (const auto& t : cfg_.tenants) {
+        if (!index.count(t.name)) add_tenant(t);
+    }
+    for (std::size_t i = 0; i < trace.size(); ++i) {
+        const Request& req = trace[i];
+        if (req.tenant.empty()) continue;
+        auto it = index.find(req.tenant);
+        if (it == index.end()) {
+            // Unlisted tenants get the default limits with their own bucket
+            TenantConfig tc = default_cfg;
+            tc.name = req.tenant;
+            add_tenant(tc);
+            it = index.find(req.tenant);
+        }
+        requests_[i].tenant_idx = it->second;
+    }
+}
+
+void Simulator::init_models(const std::vector<Request>& trace) {
+    // Index 0 is the default model for requests without a model column
+    models_.clear();
+    ModelConfig default_cfg;
+    default_cfg.name = "default";
+    for (const auto& m : cfg_.models) {
+        if (m.name == "default") default_cfg = m;
+    }
+    std::unordered_map<std::string, int> index;
+    int num_gpus = static_cast<int>(gpus_.size());
+    auto add_model = [&](const ModelConfig& mc) {
+        ModelState ms;
+        ms.cfg = mc;
+        if (ms.cfg.kv_bytes_per_token == 0) ms.cfg.kv_bytes_per_token = cfg_.policy.kv_bytes_per_token;
+        ms.on_gpu.assign(num_gpus, 0);
+        for (int g = 0; g < num_gpus; ++g) {
+            const auto& placed = cfg_.gpus[g].models;
+            if (placed.empty() || std::find(placed.begin(), placed.end(), mc.name) != placed.end()) {
+                ms.on_gpu[g] = 1;
+                ms.gpus.push_back(g);
+                if (hierarchical() && (ms.nodes.empty() || ms.nodes.back() != node_of(g))) ms.nodes.push_back(node_of(g));
+            }
+        }
+        index[mc.name] = static_cast<int>(models_.size());
+        models_.push_back(std::move(ms));
+    };
+    add_model(default_cfg);
+    for (const auto& m : cfg_.models) {
+        if (!index.count(m.name)) add_model(m);
+    }
+    for (std::size_t i = 0; i < trace.size(); ++i) {
+        const Request& req = trace[i];
+        if (req.model.empty()) continue;
+        auto it = index.find(req.model);
+        if (it == index.end()) {
+            // Unlisted models share the default geometry but keep their own placement
+            ModelConfig mc = default_cfg;
+            mc.name = req.model;
+            add_model(mc);
+            it = index.find(req.model);
+        }
+        requests_[i].model_idx = it->second;
+    }
+
+    for (auto& gpu : gpus_) gpu.model_ready_ms.assign(models_.size(), -1.0);
+    if (cfg_.model_loading == ModelLoading::Preload) {
+        for (int m = 0; m < static_cast<int>(models_.size()); ++m) {
+            for (int g : models_[m].gpus) load_weights(g, m, 0.0);
+        }
+    }
+}
+
+std::uint64_t Simulator::weights_to_load(int gpu_idx, const RequestHot& req) const {
+    if (gpus_[gpu_idx].model_ready_ms[req.model_idx] >= 0.0) return 0;
+    return models_[req.model_idx].cfg.weights_bytes;
+}
+
+void Simulator::load_weights(int gpu_idx, int model_idx, double ready_ms) {
+    // Weights are not owned by a request, so eviction never reclaims them
+    auto& gpu = gpus_[gpu_idx];
+    gpu.vram_used += models_[model_idx].cfg.weights_bytes;
+    gpu.model_ready_ms[model_idx] = ready_ms;
+    if (gpu.vram_used > peak_vram_per_gpu_[gpu_idx]) peak_vram_per_gpu_[gpu_idx] = gpu.vram_used;
+}
+
+void Simulator::ensure_model_loaded(int gpu_idx, const RequestHot& req) {
+    if (gpus_[gpu_idx].model_ready_ms[req.model_idx] >= 0.0) return;
+    auto& model = models_[req.model_idx];
+    model.swap_ins++;
+    load_weights(gpu_idx, req.model_idx, now() + model.cfg.swap_in_ms);
+}
+
+bool Simulator::admit_tenant(const RequestHot& req) {
+    auto& t = tenants_[req.tenant_idx];
+    if (t.cfg.rate_rps > 0.0) {
+        double elapsed_ms = now() - t.last_refill_ms;
+        t.bucket_tokens = std::min(t.cfg.burst, t.bucket_tokens + elapsed_ms * t.cfg.rate_rps / 1000.0);
+        t.last_refill_ms = now();
+        if (t.bucket_tokens < 1.0) {
+            t.rate_limited++;
+            return false;
+        }
+    }
+    if (t.cfg.max_inflight > 0 && t.inflight >= t.cfg.max_inflight) {
+        t.quota_rejected++;
+        return false;
     }
-    std::cout << "Finished: " << finished
-              << ", Rejected: " << rejected
-              << ", Evicted: " << evicted << '\n';
-    sim_end_ms_ = now_ms_;
+    if (t.cfg.rate_rps > 0.0) t.bucket_tokens -= 1.0;
+    return true;
+}
+
+void Simulator::release_tenant_slot(const RequestHot& req) {
+    if (active_lane_) {
+        // Only arrivals read inflight, and they never run inside a parallel window
+        active_lane_->tenant_releases[req.tenant_idx]++;
+        return;
+    }
+    auto& t = tenants_[req.tenant_idx];
+    if (t.inflight > 0) t.inflight--;
+}
+
+double Simulator::predict_ttft_ms(const RequestHot& req, int gpu_idx) const {
+    // Queued prompt work drains across max_concurrent prefill slots
+    const auto& gpu = gpus_[gpu_idx];
+    const auto& gpu_cfg = cfg_.gpus[gpu_idx];
+    double wait_ms = 0.0;
+    if (gpu.active_prefill + gpu.active_decode >= gpu_cfg.max_concurrent) {
+        double slots = static_cast<double>(std::max(1, gpu_cfg.max_concurrent));
+        wait_ms = 1000.0 * static_cast<double>(gpu.queued_prompt_tokens) / (gpu_cfg.prefill_tps * slots);
+    }
+    // Weights still loading (or about to be loaded by this admission) delay the prefill
+    double ready = gpu.model_ready_ms[req.model_idx];
+    double swap_ms = ready < 0.0 ? models_[req.model_idx].cfg.swap_in_ms : std::max(0.0, ready - now());
+    return wait_ms + swap_ms + prefill_duration_ms(req, gpu_idx);
+}
+
+void Simulator::reject_at_arrival(int req_idx, int gpu_idx) {
+    auto& req = requests_[req_idx];
+    req.state = RequestState::Rejected;
+    ctr().rejects++;
+    record_event(EventType::Reject, req_idx, gpu_idx);
 }
 
 void Simulator::precompute_topology() {
@@ -61,6 +357,21 @@ void Simulator::precompute_topology() {
     double default_bw = cfg_.policy.handoff_bandwidth_gbps;
     double default_lat = cfg_.policy.handoff_latency_us / 1000.0;  // Convert to ms
 
+    if (hierarchical()) {
+        // Resolve unset levels from the one below; no per-pair state at all
+        auto inherit = [](TopologyLevel& level, const TopologyLevel& below) {
+            if (level.bandwidth_gbps <= 0.0) level.bandwidth_gbps = below.bandwidth_gbps;
+            if (level.latency_ms < 0.0) level.latency_ms = below.latency_ms;
+        };
+        auto& h = cfg_.hierarchy;
+        inherit(h.node, TopologyLevel{default_bw, default_lat});
+        inherit(h.rack, h.node);
+        inherit(h.cluster, h.rack);
+        cfg_.bandwidth_matrix.clear();
+        cfg_.latency_matrix.clear();
+        return;
+    }
+
     // Initialize matrices: diagonal = same GPU, off-diagonal = default link
     cfg_.bandwidth_matrix.assign(num_gpus, std::vector<double>(num_gpus, default_bw));
     cfg_.latency_matrix.assign(num_gpus, std::vector<double>(num_gpus, default_lat));
@@ -107,23 +418,45 @@ double Simulator::score_gpu(int gpu_idx) const {
     return raw_load * speed_factor;
 }
 
-int Simulator::route_gpu_for_request(const Request& req) {
-    (void)req;
-    int n = static_cast<int>(gpus_.size());
-    if (n == 1) return 0;
+int Simulator::route_gpu_for_request(int req_idx) {
+    KV_PROF(perf_.routing_calls++);
+    KV_PROF_TIMER(perf_.routing_ns);
+    const auto& req = requests_[req_idx];
+    // Only GPUs serving the request's model are candidates; -1 when none does
+    const auto& hosts = models_[req.model_idx].gpus;
+    int n = static_cast<int>(hosts.size());
+    if (n == 0) return -1;
+    if (n == 1) return hosts[0];
+    bool affinity = cfg_.policy.routing_policy == RoutingPolicy::SessionAffinity;
+    if (hierarchical()) {
+        int pick = route_arrival_hierarchical(req);
+        return affinity ? prefer_session_gpu(req_idx, pick) : pick;
+    }
 
-    if (cfg_.policy.routing_policy == RoutingPolicy::P2C) {
-        auto sample_idx = [n, this]() {
-            int idx = static_cast<int>(rng_.uniform01() * n);
-            return (idx >= n) ? n - 1 : idx;
-        };
-        int a = sample_idx();
-        int b = sample_idx();
+    if (affinity) {
+        int ia = sample_index(n);
+        int ib = sample_index(n);
+        if (n > 2) {
+            while (ib == ia) ib = sample_index(n);
+        } else if (ia == ib) {
+            ib = 1 - ia;
+        }
+        int a = hosts[ia];
+        int b = hosts[ib];
+        double score_a = score_gpu(a);
+        double score_b = score_gpu(b);
+        int pick = score_a < score_b ? a : score_b < score_a ? b : (rng_.uniform01() < 0.5 ? a : b);
+        return prefer_session_gpu(req_idx, pick);
+    } else if (cfg_.policy.routing_policy == RoutingPolicy::P2C) {
+        int ia = sample_index(n);
+        int ib = sample_index(n);
         if (n > 2) {
-            while (b == a) b = sample_idx();
-        } else if (a == b) {
-            b = 1 - a;
+            while (ib == ia) ib = sample_index(n);
+        } else if (ia == ib) {
+            ib = 1 - ia;
         }
+        int a = hosts[ia];
+        int b = hosts[ib];
         double score_a = score_gpu(a);
         double score_b = score_gpu(b);
         if (score_a < score_b) return a;
@@ -131,21 +464,24 @@ int Simulator::route_gpu_for_request(const Request& req) {
         // Tie: pick randomly to avoid bias
         return (rng_.uniform01() < 0.5) ? a : b;
     } else if (cfg_.policy.routing_policy == RoutingPolicy::RoundRobin) {
-        return 0;  // TODO: implement round-robin
+        return hosts[0];  // TODO: implement round-robin
     } else if (cfg_.policy.routing_policy == RoutingPolicy::LeastLoaded) {
-        return 0;  // TODO: implement least-loaded
+        return hosts[0];  // TODO: implement least-loaded
     }
-    return 0;
+    return hosts[0];
 }
 
-int Simulator::route_decode(int prefill_gpu, const Request& req) {
+int Simulator::route_decode(int prefill_gpu, const RequestHot& req) {
+    KV_PROF(perf_.routing_calls++);
+    KV_PROF_TIMER(perf_.routing_ns);
     int n = static_cast<int>(gpus_.size());
     if (n == 1) return prefill_gpu;
+    if (hierarchical()) return route_decode_hierarchical(prefill_gpu, req);
 
     double best_score = std::numeric_limits<double>::infinity();
     int best_gpu = -1;
     for (int gpu_idx = 0; gpu_idx < n; ++gpu_idx) {
-        if (!can_fit_kv(gpu_idx, req)) continue;
+        if (!serves_model(gpu_idx, req) || !can_fit_kv(gpu_idx, req)) continue;
         double score = compute_decode_score(prefill_gpu, gpu_idx, req);
         if (score < best_score) {
             best_score = score;
@@ -156,33 +492,148 @@ int Simulator::route_decode(int prefill_gpu, const Request& req) {
     return best_gpu;
 }
 
-bool Simulator::can_fit_kv(int gpu_idx, const Request& req) const {
+bool Simulator::can_fit_kv(int gpu_idx, const RequestHot& req) const {
     const auto& gpu = gpus_[gpu_idx];
     const auto& gpu_cfg = cfg_.gpus[gpu_idx];
-    std::uint64_t need = static_cast<std::uint64_t>(req.prompt_tokens + req.gen_tokens) * cfg_.policy.kv_bytes_per_token;
-    return gpu.vram_used + need <= gpu_cfg.vram_bytes;
+    std::uint64_t need = static_cast<std::uint64_t>(req.prompt_tokens + reserved_gen_tokens(req)) * kv_bytes_per_token(req);
+    return gpu.vram_used - gpu.retained_bytes + need + weights_to_load(gpu_idx, req) <= gpu_cfg.vram_bytes;
+}
+
+int Simulator::reserved_gen_tokens(const RequestHot& req) const {
+    return cfg_.policy.predicted_reservation ? req.predicted_gen_tokens : req.gen_tokens;
 }
 
 double Simulator::get_link_bandwidth(int src_idx, int dest_idx) const {
     if (src_idx == dest_idx) return std::numeric_limits<double>::infinity();
+    if (hierarchical()) return path_level(src_idx, dest_idx).bandwidth_gbps;
     return cfg_.bandwidth_matrix[src_idx][dest_idx];
 }
 
 double Simulator::get_link_latency(int src_idx, int dest_idx) const {
     if (src_idx == dest_idx) return 0.0;
+    if (hierarchical()) return path_level(src_idx, dest_idx).latency_ms;
     return cfg_.latency_matrix[src_idx][dest_idx];
 }
 
-double Simulator::estimate_handoff_ms(int src_idx, int dest_idx, const Request& req) const {
+int Simulator::num_nodes() const {
+    int per_node = cfg_.hierarchy.gpus_per_node;
+    return (static_cast<int>(gpus_.size()) + per_node - 1) / per_node;
+}
+
+const TopologyLevel& Simulator::path_level(int src_idx, int dest_idx) const {
+    const auto& h = cfg_.hierarchy;
+    int src_node = node_of(src_idx);
+    int dest_node = node_of(dest_idx);
+    if (src_node == dest_node) return h.node;
+    if (h.nodes_per_rack <= 0 || src_node / h.nodes_per_rack == dest_node / h.nodes_per_rack) return h.rack;
+    return h.cluster;
+}
+
+double Simulator::node_score(int node) const {
+    int first = node * cfg_.hierarchy.gpus_per_node;
+    int last = std::min(first + cfg_.hierarchy.gpus_per_node, static_cast<int>(gpus_.size()));
+    double sum = 0.0;
+    for (int g = first; g < last; ++g) sum += score_gpu(g);
+    return sum / (last - first);
+}
+
+int Simulator::sample_index(int n) {
+    int idx = static_cast<int>(rng_.uniform01() * n);
+    return (idx >= n) ? n - 1 : idx;
+}
+
+int Simulator::route_arrival_hierarchical(const RequestHot& req) {
+    // Power of two choices over nodes by mean load, then the least-loaded GPU in the node.
+    // Both levels only consider where the request's model is placed.
+    const auto& model = models_[req.model_idx];
+    int nodes = static_cast<int>(model.nodes.size());
+    int node = model.nodes[0];
+    if (nodes > 1) {
+        int ia = sample_index(nodes);
+        int ib = sample_index(nodes);
+        if (nodes > 2) {
+            while (ib == ia) ib = sample_index(nodes);
+        } else if (ia == ib) {
+            ib = 1 - ia;
+        }
+        int a = model.nodes[ia];
+        int b = model.nodes[ib];
+        double score_a = node_score(a);
+        double score_b = node_score(b);
+        if (score_a < score_b) node = a;
+        else if (score_b < score_a) node = b;
+        else node = (rng_.uniform01() < 0.5) ? a : b;
+    }
+    int first = node * cfg_.hierarchy.gpus_per_node;
+    int last = std::min(first + cfg_.hierarchy.gpus_per_node, static_cast<int>(gpus_.size()));
+    int best = -1;
+    for (int g = first; g < last; ++g) {
+        if (model.on_gpu[g] && (best < 0 || score_gpu(g) < score_gpu(best))) best = g;
+    }
+    return best;
+}
+
+int Simulator::route_decode_hierarchical(int prefill_gpu, const RequestHot& req) {
+    // Candidates: the prefill node plus up to two sampled remote nodes; full decode score
+    // (load + handoff cost) for each of their GPUs
+    const auto& model = models_[req.model_idx];
+    int nodes = static_cast<int>(model.nodes.size());
+    int candidates[3] = {node_of(prefill_gpu), -1, -1};
+    int count = 1;
+    int want = 1 + std::min(2, nodes - 1);
+    while (count < want) {
+        int n = model.nodes[sample_index(nodes)];
+        if (std::find(candidates, candidates + count, n) == candidates + count) candidates[count++] = n;
+    }
+    double best_score = std::numeric_limits<double>::infinity();
+    int best_gpu = -1;
+    for (int c = 0; c < count; ++c) {
+        int first = candidates[c] * cfg_.hierarchy.gpus_per_node;
+        int last = std::min(first + cfg_.hierarchy.gpus_per_node, static_cast<int>(gpus_.size()));
+        for (int gpu_idx = first; gpu_idx < last; ++gpu_idx) {
+            if (!model.on_gpu[gpu_idx] || !can_fit_kv(gpu_idx, req)) continue;
+            double score = compute_decode_score(prefill_gpu, gpu_idx, req);
+            if (score < best_score) {
+                best_score = score;
+                best_gpu = gpu_idx;
+            }
+        }
+    }
+    return best_gpu == -1 ? prefill_gpu : best_gpu;
+}
+
+double Simulator::estimate_handoff_ms(int src_idx, int dest_idx, const RequestHot& req) const {
     if (src_idx == dest_idx) return 0.0;
     double bandwidth_gbps = get_link_bandwidth(src_idx, dest_idx);
     double latency_ms = get_link_latency(src_idx, dest_idx);
-    double bytes = static_cast<double>(req.prompt_tokens + req.gen_tokens) * cfg_.policy.kv_bytes_per_token;
+    double bytes = static_cast<double>(req.prompt_tokens + req.gen_tokens) * kv_bytes_per_token(req);
     double transfer_ms = bytes / (bandwidth_gbps * 1e6);
     return latency_ms + transfer_ms;
 }
 
-double Simulator::compute_decode_score(int src_idx, int dest_idx, const Request& req) const {
+double Simulator::handoff_tail_ms(int src_idx, int dest_idx, const RequestHot& req) const {
+    const auto& p = cfg_.policy;
+    if (p.handoff_mode == HandoffMode::Whole || src_idx == dest_idx) return estimate_handoff_ms(src_idx, dest_idx, req);
+    // Layer l's KV is ready at (l + 1) / L of the prefill. Chunks go over the link in
+    // order, each paying the fixed per-transfer overhead, so only the tail after the
+    // last layer is left once prefill ends.
+    int layers = p.handoff_layers;
+    int chunk = std::min(p.handoff_chunk_layers, layers);
+    double prefill_ms = prefill_duration_ms(req, src_idx);
+    double bytes = static_cast<double>(req.prompt_tokens + req.gen_tokens) * kv_bytes_per_token(req);
+    double layer_ms = bytes / layers / (get_link_bandwidth(src_idx, dest_idx) * 1e6);
+    double overhead_ms = p.handoff_latency_us / 1000.0;
+    double link_free_ms = 0.0;
+    for (int sent = 0; sent < layers;) {
+        int n = std::min(chunk, layers - sent);
+        sent += n;
+        double ready_ms = prefill_ms * sent / layers;
+        link_free_ms = std::max(link_free_ms, ready_ms) + overhead_ms + n * layer_ms;
+    }
+    return link_free_ms + get_link_latency(src_idx, dest_idx) - prefill_ms;
+}
+
+double Simulator::compute_decode_score(int src_idx, int dest_idx, const RequestHot& req) const {
     const auto& gpu = gpus_[dest_idx];
     const auto& gpu_cfg = cfg_.gpus[dest_idx];
 
@@ -190,18 +641,24 @@ double Simulator::compute_decode_score(int src_idx, int dest_idx, const Request&
     double decode_speed_factor = 500.0 / gpu_cfg.decode_tps;
     double load_score = raw_load * decode_speed_factor;
 
-    double handoff_cost = cfg_.policy.handoff_cost_weight * estimate_handoff_ms(src_idx, dest_idx, req);
+    double handoff_cost = cfg_.policy.handoff_cost_weight * handoff_tail_ms(src_idx, dest_idx, req);
 
     return load_score + handoff_cost;
 }
 
 void Simulator::schedule_arrivals() {
     for (int i = 0; i < static_cast<int>(requests_.size()); ++i) {
-        pq_.push(Event{requests_[i].arrival_time_ms, EventType::Arrival, i, -1});
+        push_event(Event{requests_.arrival_ms[i], EventType::Arrival, i, -1});
     }
 }
 
 void Simulator::handle_event(const Event& event) {
+    KV_PROF(perf().events_processed++);
+    KV_PROF(perf().event_counts[static_cast<int>(event.type)]++);
+    KV_PROF_TIMER(perf().handler_ns[static_cast<int>(event.type)]);
+    if (event.type != EventType::SessionExpire && event.type != EventType::TimerTick) {
+        ctr().last_request_event_ms = event.time_ms;
+    }
     switch (event.type) {
         case EventType::Arrival:        on_arrival(event); break;
         case EventType::StartPrefill:   on_start_prefill(event); break;
@@ -209,6 +666,10 @@ void Simulator::handle_event(const Event& event) {
         case EventType::HandoffStart:   on_handoff_start(event); break;
         case EventType::HandoffComplete: on_handoff_complete(event); break;
         case EventType::Finish:         on_finish(event); break;
+        case EventType::KvGrow:         on_kv_grow(event); break;
+        case EventType::SessionExpire:  on_session_expire(event); break;
+        case EventType::Abandon:        on_abandon(event); break;
+        case EventType::TimerTick:      on_timer_tick(event); break;
         default: break;
     }
 }
@@ -217,14 +678,14 @@ bool Simulator::can_admit_prompt(int prompt_tokens, int gpu_idx) const {
     auto& gpu = gpus_[gpu_idx];
     auto& gpu_cfg = cfg_.gpus[gpu_idx];
     std::uint64_t need = static_cast<std::uint64_t>(prompt_tokens) * cfg_.policy.kv_bytes_per_token;
-    return gpu.vram_used + need <= gpu_cfg.vram_bytes;
+    return gpu.vram_used - gpu.retained_bytes + need <= gpu_cfg.vram_bytes;
 }
 
 bool Simulator::can_reserve_decode(int prompt_tokens, int gen_tokens, int gpu_idx) const {
     auto& gpu = gpus_[gpu_idx];
     auto& gpu_cfg = cfg_.gpus[gpu_idx];
     std::uint64_t need = static_cast<std::uint64_t>(prompt_tokens + gen_tokens) * cfg_.policy.kv_bytes_per_token;
-    return gpu.vram_used + need <= gpu_cfg.vram_bytes;
+    return gpu.vram_used - gpu.retained_bytes + need <= gpu_cfg.vram_bytes;
 }
 
 void Simulator::allocate_kv_bytes(int req_idx, std::uint64_t bytes, int gpu_idx) {
@@ -248,36 +709,45 @@ void Simulator::free_kv_bytes(int req_idx, std::uint64_t bytes, int gpu_idx) {
     gpu.allocated_bytes[req_idx] -= to_free;
 }
 
-double Simulator::prefill_duration_ms(int prompt_tokens, int gpu_idx) const {
-    return 1000.0 * prompt_tokens / cfg_.gpus[gpu_idx].prefill_tps;
+double Simulator::prefill_duration_ms(const RequestHot& req, int gpu_idx) const {
+    double tps = cfg_.gpus[gpu_idx].prefill_tps * models_[req.model_idx].cfg.prefill_speed;
+    return 1000.0 * (req.prompt_tokens - req.cached_tokens) / tps;
 }
 
-double Simulator::decode_duration_ms(int gen_tokens, int active_decode, int gpu_idx) const {
+double Simulator::decode_duration_ms(const RequestHot& req, int active_decode, int gpu_idx) const {
     int share = std::max(1, std::min(active_decode, cfg_.gpus[gpu_idx].decode_sharing_cap));
     double eff = cfg_.gpus[gpu_idx].decode_efficiency;
-    double effective_tps = cfg_.gpus[gpu_idx].decode_tps * eff / static_cast<double>(share);
+    double tps = cfg_.gpus[gpu_idx].decode_tps * models_[req.model_idx].cfg.decode_speed;
+    double effective_tps = tps * eff / static_cast<double>(share);
     if (effective_tps <= 0.0) return 0.0;
-    return 1000.0 * gen_tokens / effective_tps;
+    return 1000.0 * req.gen_tokens / effective_tps;
 }
 
 void Simulator::on_arrival(const Event& event) {
     auto& req = requests_[event.request_index];
-    if (req.state == RequestState::Evicted || req.state == RequestState::Rejected || req.state == RequestState::Finished) {
+    if (request_left(req.state)) {
+        return;
+    }
+    if (models_[req.model_idx].gpus.empty() || !admit_tenant(req)) {
+        reject_at_arrival(event.request_index, -1);
         return;
     }
+    auto& tenant = tenants_[req.tenant_idx];
+    bool slo_check = cfg_.policy.slo_admission && tenant.cfg.ttft_slo_ms > 0.0;
+
     // Route at arrival time (when actual GPU state is known)
-    int gpu_idx = route_gpu_for_request(req);
+    int gpu_idx = route_gpu_for_request(event.request_index);
     auto& gpu = gpus_[gpu_idx];
     int queued = static_cast<int>(gpu.prefill_queue.size());
     int active = gpu.active_prefill + gpu.active_decode;
 
     // Check primary GPU
     bool can_accept = queued + active < cfg_.policy.max_queue;
-    int reserved_tokens = req.prompt_tokens + (cfg_.policy.safe_reservation ? req.gen_tokens : 0);
-    std::uint64_t need = static_cast<std::uint64_t>(reserved_tokens) * cfg_.policy.kv_bytes_per_token;
+    int reserved_tokens = req.prompt_tokens + (cfg_.policy.safe_reservation ? reserved_gen_tokens(req) : 0);
+    std::uint64_t need = static_cast<std::uint64_t>(reserved_tokens) * kv_bytes_per_token(req);
 
     if (can_accept) {
-        can_accept = ensure_capacity_for(need, gpu_idx);
+        can_accept = ensure_capacity_for(need + weights_to_load(gpu_idx, req), gpu_idx);
     }
 
     // If primary can't accept, try alternate GPU
@@ -285,13 +755,22 @@ void Simulator::on_arrival(const Event& event) {
         int alternate_gpu = find_alternate_gpu(gpu_idx, req);
         if (alternate_gpu != -1) {
             gpu_idx = alternate_gpu;
-            can_accept = ensure_capacity_for(need, gpu_idx);
+            can_accept = ensure_capacity_for(need + weights_to_load(gpu_idx, req), gpu_idx);
         }
     }
 
+    // Deadline-aware admission: a global-queue wait has no bound, so it counts as a miss
+    if (slo_check && (!can_accept || predict_ttft_ms(req, gpu_idx) > tenant.cfg.ttft_slo_ms)) {
+        tenant.slo_rejected++;
+        reject_at_arrival(event.request_index, can_accept ? gpu_idx : -1);
+        return;
+    }
+    tenant.inflight++;
+    arm_timeout(event.request_index);
+
     // If still can't accept, push to global queue
     if (!can_accept) {
-        global_queue_.push_back(event.request_index);
+        enqueue_global(event.request_index, now());
         // Phase 8: Track max global queue depth
         int current_depth = static_cast<int>(global_queue_.size());
         if (current_depth > max_global_queue_depth_) {
@@ -301,35 +780,41 @@ void Simulator::on_arrival(const Event& event) {
     }
 
     auto& target_gpu = gpus_[gpu_idx];
+    ensure_model_loaded(gpu_idx, req);
+    claim_session_kv(event.request_index, gpu_idx);
     allocate_kv_bytes(event.request_index, need, gpu_idx);
     req.state = RequestState::Queued;
-    record_event(EventType::Arrival, req, gpu_idx);
+    record_event(EventType::Arrival, event.request_index, gpu_idx);
 
     target_gpu.evict_queue.push_back(event.request_index);
     touch_lru(event.request_index, gpu_idx);
 
     if (target_gpu.active_prefill + target_gpu.active_decode < cfg_.gpus[gpu_idx].max_concurrent) {
         target_gpu.active_prefill++;
-        pq_.push(Event{now_ms_, EventType::StartPrefill, event.request_index, gpu_idx});
+        push_event(Event{now(), EventType::StartPrefill, event.request_index, gpu_idx});
     } else {
-        target_gpu.prefill_queue.push_back(event.request_index);
+        enqueue_prefill(event.request_index, gpu_idx);
     }
 }
 
-int Simulator::find_alternate_gpu(int exclude_gpu, const Request& req) const {
+int Simulator::find_alternate_gpu(int exclude_gpu, const RequestHot& req) const {
     int n = static_cast<int>(gpus_.size());
     int best_gpu = -1;
     double best_score = std::numeric_limits<double>::infinity();
     for (int i = 0; i < n; ++i) {
-        if (i == exclude_gpu) continue;
+        if (i == exclude_gpu || !serves_model(i, req)) continue;
         auto& gpu = gpus_[i];
         int queued = static_cast<int>(gpu.prefill_queue.size());
         int active = gpu.active_prefill + gpu.active_decode;
 
         if (queued + active >= cfg_.policy.max_queue) continue;
-        int reserved_tokens = req.prompt_tokens + (cfg_.policy.safe_reservation ? req.gen_tokens : 0);
-        std::uint64_t need = static_cast<std::uint64_t>(reserved_tokens) * cfg_.policy.kv_bytes_per_token;
-        if(gpu.vram_used + need > cfg_.gpus[i].vram_bytes && cfg_.policy.memory_pressure_policy == MemoryPressurePolicy::Reject) continue;
+        int reserved_tokens = req.prompt_tokens + (cfg_.policy.safe_reservation ? reserved_gen_tokens(req) : 0);
+        std::uint64_t need = static_cast<std::uint64_t>(reserved_tokens) * kv_bytes_per_token(req) + weights_to_load(i, req);
+        // Retained session KV is dropped on demand, so it counts as free here
+        if (gpu.vram_used - gpu.retained_bytes + need > cfg_.gpus[i].vram_bytes &&
+            cfg_.policy.memory_pressure_policy == MemoryPressurePolicy::Reject) {
+            continue;
+        }
         double score = score_gpu(i);
         if (score < best_score) {
             best_score = score;
@@ -346,65 +831,108 @@ void Simulator::try_dispatch_global_queue() {
         max_global_queue_depth_ = current_depth;
     }
 
-    while (!global_queue_.empty()){
-        int req_idx = global_queue_.front();
+    // Visit bucket heads oldest first. FIFO stops at the first waiter that does not
+    // fit; Backfill closes that bucket and tries the next-oldest head, unless the
+    // blocked waiter has aged past global_aging_ms. Each call makes at most one failed
+    // attempt per bucket, however long the queue is.
+    bool backfill = cfg_.policy.global_dispatch == GlobalDispatch::Backfill;
+    double aging_ms = cfg_.policy.global_aging_ms;
+    std::uint64_t open = global_queue_.nonempty_mask();
+    bool overtaking = false;
+    while (true) {
+        int bucket = global_queue_.oldest_bucket(open);
+        if (bucket < 0) break;
+        const auto& head = global_queue_.head(bucket);
+        int req_idx = head.req_idx;
         auto& req = requests_[req_idx];
 
-        if (req.state == RequestState::Evicted || req.state == RequestState::Rejected || req.state == RequestState::Finished) {
-            global_queue_.pop_front();
+        if (request_left(req.state)) {
+            global_queue_.pop_head(bucket);
             continue;
         }
 
-        int gpu_idx = find_alternate_gpu(-1, req); 
-        // no alternate GPU found, break
-        if (gpu_idx == -1){
-            break;
+        int gpu_idx = find_alternate_gpu(-1, req);
+        int reserved_tokens = req.prompt_tokens + (cfg_.policy.safe_reservation ? reserved_gen_tokens(req) : 0);
+        std::uint64_t need = static_cast<std::uint64_t>(reserved_tokens) * kv_bytes_per_token(req);
+        if (gpu_idx == -1 || !ensure_capacity_for(need + weights_to_load(gpu_idx, req), gpu_idx)) {
+            bool starving = aging_ms > 0.0 && now() - head.enqueued_ms >= aging_ms;
+            if (!backfill || (starving && !overtaking)) break;
+            open &= ~(std::uint64_t{1} << bucket);
+            overtaking = true;
+            continue;
         }
-        global_queue_.pop_front();
+        global_queue_.pop_head(bucket);
+        if (overtaking) global_backfills_++;
         auto& gpu = gpus_[gpu_idx];
-        int reserved_tokens = req.prompt_tokens + (cfg_.policy.safe_reservation ? req.gen_tokens : 0);
-        std::uint64_t need = static_cast<std::uint64_t>(reserved_tokens) * cfg_.policy.kv_bytes_per_token;
-        
-        if(!ensure_capacity_for(need, gpu_idx)) {
-            global_queue_.push_front(req_idx);
-            break;
-        }
 
+        ensure_model_loaded(gpu_idx, req);
+        claim_session_kv(req_idx, gpu_idx);
         allocate_kv_bytes(req_idx, need, gpu_idx);
         req.state = RequestState::Queued;
-        record_event(EventType::Arrival, req, gpu_idx);
+        record_event(EventType::Arrival, req_idx, gpu_idx);
         gpu.evict_queue.push_back(req_idx);
         touch_lru(req_idx, gpu_idx);
 
         if (gpu.active_prefill + gpu.active_decode < cfg_.gpus[gpu_idx].max_concurrent) {
             gpu.active_prefill++;
-            pq_.push(Event{now_ms_, EventType::StartPrefill, req_idx, gpu_idx});
+            push_event(Event{now(), EventType::StartPrefill, req_idx, gpu_idx});
         } else {
-            gpu.prefill_queue.push_back(req_idx);
+            enqueue_prefill(req_idx, gpu_idx);
         }
     }
 }
 
+void Simulator::enqueue_global(int req_idx, double enqueued_ms) {
+    int bucket = 0;
+    if (cfg_.policy.global_dispatch == GlobalDispatch::Backfill) {
+        const auto& req = requests_[req_idx];
+        int reserved_tokens = req.prompt_tokens + (cfg_.policy.safe_reservation ? reserved_gen_tokens(req) : 0);
+        bucket = GlobalQueue::bucket_for(static_cast<std::uint64_t>(reserved_tokens) * kv_bytes_per_token(req));
+    }
+    global_queue_.push(req_idx, bucket, enqueued_ms);
+}
+
+void Simulator::enqueue_prefill(int req_idx, int gpu_idx) {
+    auto& gpu = gpus_[gpu_idx];
+    const auto& req = requests_[req_idx];
+    double key = 0.0;  // FIFO: ordering falls back to insertion sequence
+    switch (cfg_.policy.scheduling) {
+        case SchedulingMode::FIFO:
+            break;
+        case SchedulingMode::ShortestRemaining:
+            key = static_cast<double>(req.prompt_tokens + req.gen_tokens);
+            break;
+        case SchedulingMode::PredictedShortest:
+            key = static_cast<double>(req.prompt_tokens + req.predicted_gen_tokens);
+            break;
+        case SchedulingMode::Priority:
+            key = static_cast<double>(req.priority);
+            break;
+        case SchedulingMode::WeightedFair: {
+            // Self-clocked fair queuing: finish tag = max(V, last tag of class) + cost / weight
+            int cls = std::max(0, static_cast<int>(req.priority));
+            if (cls >= static_cast<int>(gpu.wfq_last_finish.size())) {
+                gpu.wfq_last_finish.resize(cls + 1, 0.0);
+            }
+            double start = std::max(gpu.wfq_virtual_time, gpu.wfq_last_finish[cls]);
+            double cost = static_cast<double>(req.prompt_tokens + req.predicted_gen_tokens);
+            key = start + cost / cfg_.policy.class_weight(cls);
+            gpu.wfq_last_finish[cls] = key;
+            break;
+        }
+    }
+    gpu.prefill_queue.push(req_idx, key);
+    gpu.queued_prompt_tokens += static_cast<std::uint64_t>(req.prompt_tokens);
+}
+
 int Simulator::pick_next_from_queue(int gpu_idx) {
     auto& gpu = gpus_[gpu_idx];
     if (gpu.prefill_queue.empty()) return -1;
-    if (cfg_.policy.scheduling == SchedulingMode::FIFO) {
-        int idx = gpu.prefill_queue.front();
-        gpu.prefill_queue.pop_front();
-        return idx;
-    }
-    // Shortest remaining
-    auto best_it = gpu.prefill_queue.begin();
-    int best_tokens = requests_[*best_it].prompt_tokens + requests_[*best_it].gen_tokens;
-    for (auto it = std::next(gpu.prefill_queue.begin()); it != gpu.prefill_queue.end(); ++it) {
-        int tokens = requests_[*it].prompt_tokens + requests_[*it].gen_tokens;
-        if (tokens < best_tokens) {
-            best_it = it;
-            best_tokens = tokens;
-        }
-    }
-    int idx = *best_it;
-    gpu.prefill_queue.erase(best_it);
+    if (cfg_.policy.scheduling == SchedulingMode::WeightedFair) {
+        gpu.wfq_virtual_time = gpu.prefill_queue.top_key();
+    }
+    int idx = gpu.prefill_queue.pop();
+    gpu.queued_prompt_tokens -= static_cast<std::uint64_t>(requests_[idx].prompt_tokens);
     return idx;
 }
 
@@ -414,7 +942,7 @@ void Simulator::try_start_prefill(int gpu_idx) {
         int req_idx = pick_next_from_queue(gpu_idx);
         if (req_idx < 0) break;
         gpu.active_prefill++;  // Increment now to prevent over-scheduling
-        pq_.push(Event{now_ms_, EventType::StartPrefill, req_idx, gpu_idx});
+        push_event(Event{now(), EventType::StartPrefill, req_idx, gpu_idx});
     }
 }
 
@@ -422,25 +950,31 @@ void Simulator::on_start_prefill(const Event& event) {
     int gpu_idx = event.gpu_index;
     auto& gpu = gpus_[gpu_idx];
     auto& req = requests_[event.request_index];
-    if (req.state == RequestState::Evicted || req.state == RequestState::Rejected || req.state == RequestState::Finished) {
+    if (request_left(req.state)) {
         gpu.active_prefill--;
         try_start_prefill(gpu_idx);
         return;
     }
+    double ready_ms = gpu.model_ready_ms[req.model_idx];
+    if (ready_ms > now()) {
+        // Holds its prefill slot until the model's weights finish loading
+        push_event(Event{ready_ms, EventType::StartPrefill, event.request_index, gpu_idx});
+        return;
+    }
     req.state = RequestState::Prefill;
-    req.start_prefill_ms = now_ms_;
+    requests_.start_prefill_ms[event.request_index] = now();
     req.prefill_gpu = gpu_idx;
     touch_lru(event.request_index, gpu_idx);
-    record_event(EventType::StartPrefill, req, gpu_idx);
-    double duration = prefill_duration_ms(req.prompt_tokens, gpu_idx);
-    pq_.push(Event{now_ms_ + duration, EventType::StartDecode, event.request_index, gpu_idx});
+    record_event(EventType::StartPrefill, event.request_index, gpu_idx);
+    double duration = prefill_duration_ms(req, gpu_idx);
+    push_event(Event{now() + duration, EventType::StartDecode, event.request_index, gpu_idx});
 }
 
 void Simulator::on_start_decode(const Event& event) {
     int gpu_idx = event.gpu_index;
     auto& gpu = gpus_[gpu_idx];
     auto& req = requests_[event.request_index];
-    if (req.state == RequestState::Evicted || req.state == RequestState::Rejected || req.state == RequestState::Finished) {
+    if (request_left(req.state)) {
         return;
     }
 
@@ -452,18 +986,18 @@ void Simulator::on_start_decode(const Event& event) {
     int decode_gpu_idx = route_decode(gpu_idx, req);
     req.decode_gpu = decode_gpu_idx;
     if (decode_gpu_idx != gpu_idx) {
-        pq_.push(Event{now_ms_ + cfg_.policy.handoff_latency_us / 1000.0, EventType::HandoffStart, event.request_index, decode_gpu_idx});
+        push_event(Event{now() + cfg_.policy.handoff_latency_us / 1000.0, EventType::HandoffStart, event.request_index, decode_gpu_idx});
         if (is_first_decode_attempt) {
             try_start_prefill(gpu_idx);
         }
         return;
     }
     req.state = RequestState::Decode;
-    req.start_decode_ms = now_ms_;
+    req.start_decode_ms = now();
     gpu.active_decode++;
 
     if (!cfg_.policy.safe_reservation) {
-        std::uint64_t need = static_cast<std::uint64_t>(req.gen_tokens) * cfg_.policy.kv_bytes_per_token;
+        std::uint64_t need = static_cast<std::uint64_t>(reserved_gen_tokens(req)) * kv_bytes_per_token(req);
         if (!ensure_capacity_for(need, gpu_idx)) {
             req.retry_count++;
             retry_attempts_++;  // Phase 8: Track retry attempt
@@ -472,64 +1006,81 @@ void Simulator::on_start_decode(const Event& event) {
                 if (alt_gpu != -1) {
                     retry_successes_++;  // Phase 8: Track successful retry
                     gpu.active_decode--;
-                    pq_.push(Event{now_ms_, EventType::HandoffStart, event.request_index, alt_gpu});
+                    push_event(Event{now(), EventType::HandoffStart, event.request_index, alt_gpu});
                     return;
                 }
             }
             req.state = RequestState::Rejected;
-            rejects_total_++;
+            release_tenant_slot(req);
+            cancel_pending_events(event.request_index);
+            ctr().rejects++;
             gpu.active_decode--;
-            record_event(EventType::Reject, req, gpu_idx);
-            free_kv_bytes(event.request_index, static_cast<std::uint64_t>(req.prompt_tokens) * cfg_.policy.kv_bytes_per_token, gpu_idx);
+            record_event(EventType::Reject, event.request_index, gpu_idx);
+            free_kv_bytes(event.request_index, static_cast<std::uint64_t>(req.prompt_tokens) * kv_bytes_per_token(req), gpu_idx);
             try_start_prefill(gpu_idx);
             return;
         }
         allocate_kv_bytes(event.request_index, need, gpu_idx);
     }
     touch_lru(event.request_index, gpu_idx);
-    record_event(EventType::StartDecode, req, gpu_idx);
-    double duration = decode_duration_ms(req.gen_tokens, gpu.active_decode, gpu_idx);
-    pq_.push(Event{now_ms_ + duration, EventType::Finish, event.request_index, gpu_idx});
+    record_event(EventType::StartDecode, event.request_index, gpu_idx);
+    schedule_decode_finish(event.request_index, gpu_idx);
 }
 
 void Simulator::on_handoff_start(const Event& event) {
     int dest_gpu_idx = event.gpu_index;
     auto& req = requests_[event.request_index];
+    // The client is gone and its KV already freed; copying would strand it on dest
+    if (req.state == RequestState::Abandoned) return;
     int src_gpu_idx = req.prefill_gpu;
     auto& src_gpu = gpus_[src_gpu_idx];
 
     std::uint64_t bytes_to_copy = src_gpu.allocated_bytes[event.request_index];
 
-    if (!ensure_capacity_for(bytes_to_copy, dest_gpu_idx)) {
+    if (!ensure_capacity_for(bytes_to_copy + weights_to_load(dest_gpu_idx, req), dest_gpu_idx)) {
         req.retry_count++;
         retry_attempts_++;  // Phase 8: Track retry attempt
         if (req.retry_count < cfg_.policy.max_admission_retries) {
             int alt_gpu = find_alternate_gpu(src_gpu_idx, req);
             if (alt_gpu != -1 && alt_gpu != dest_gpu_idx) {
                 retry_successes_++;  // Phase 8: Track successful retry
-                pq_.push(Event{now_ms_, EventType::HandoffStart, event.request_index, alt_gpu});
+                push_event(Event{now(), EventType::HandoffStart, event.request_index, alt_gpu});
                 return;
             }
         }
         req.state = RequestState::Rejected;
-        rejects_total_++;
-        record_event(EventType::Reject, req, src_gpu_idx);
+        release_tenant_slot(req);
+        cancel_pending_events(event.request_index);
+        ctr().rejects++;
+        record_event(EventType::Reject, event.request_index, src_gpu_idx);
         free_kv_bytes(event.request_index, bytes_to_copy, src_gpu_idx);
         return;
     }
 
     handoffs_total_++;  // Phase 8: Track successful handoff
+    ensure_model_loaded(dest_gpu_idx, req);
     allocate_kv_bytes(event.request_index, bytes_to_copy, dest_gpu_idx);
     double transfer_ms = estimate_handoff_ms(src_gpu_idx, dest_gpu_idx, req);
-    record_event(EventType::HandoffStart, req, dest_gpu_idx);
-    pq_.push(Event{now_ms_ + transfer_ms, EventType::HandoffComplete, event.request_index, dest_gpu_idx});
+    double done_ms = now() + transfer_ms;
+    // Only the routed handoff streams during prefill; a retry elsewhere copies everything
+    if (cfg_.policy.handoff_mode == HandoffMode::Layerwise && req.retry_count == 0) {
+        double prefill_end_ms = requests_.start_prefill_ms[event.request_index] + prefill_duration_ms(req, src_gpu_idx);
+        done_ms = std::max(now(), prefill_end_ms + handoff_tail_ms(src_gpu_idx, dest_gpu_idx, req));
+        handoffs_pipelined_++;
+        handoff_whole_ms_ += cfg_.policy.handoff_latency_us / 1000.0 + transfer_ms;
+        handoff_exposed_ms_ += done_ms - prefill_end_ms;
+    }
+    record_event(EventType::HandoffStart, event.request_index, dest_gpu_idx);
+    // Decode cannot start before the destination has the model's weights
+    done_ms = std::max(done_ms, gpus_[dest_gpu_idx].model_ready_ms[req.model_idx]);
+    push_event(Event{done_ms, EventType::HandoffComplete, event.request_index, dest_gpu_idx});
 }
 
 void Simulator::on_handoff_complete(const Event& event) {
     int dest_gpu_idx = event.gpu_index;
     int req_idx = event.request_index;
     auto& req = requests_[req_idx];
-    if (req.state == RequestState::Evicted || req.state == RequestState::Rejected || req.state == RequestState::Finished) {
+    if (request_left(req.state)) {
         return;
     }
     int src_gpu_idx = req.prefill_gpu;
@@ -538,15 +1089,17 @@ void Simulator::on_handoff_complete(const Event& event) {
 
     // Free KV from source GPU (handoff complete)
     free_kv_bytes(req_idx, src_gpu.allocated_bytes[req_idx], src_gpu_idx);
-    record_event(EventType::HandoffComplete, req, dest_gpu_idx);
+    record_event(EventType::HandoffComplete, req_idx, dest_gpu_idx);
 
     // If safe_reservation=false, need to allocate decode bytes on dest GPU
     if (!cfg_.policy.safe_reservation) {
-        std::uint64_t need = static_cast<std::uint64_t>(req.gen_tokens) * cfg_.policy.kv_bytes_per_token;
+        std::uint64_t need = static_cast<std::uint64_t>(reserved_gen_tokens(req)) * kv_bytes_per_token(req);
         if (!ensure_capacity_for(need, dest_gpu_idx)) {
             req.state = RequestState::Rejected;
-            rejects_total_++;
-            record_event(EventType::Reject, req, dest_gpu_idx);
+            release_tenant_slot(req);
+            cancel_pending_events(req_idx);
+            ctr().rejects++;
+            record_event(EventType::Reject, req_idx, dest_gpu_idx);
             free_kv_bytes(req_idx, dest_gpu.allocated_bytes[req_idx], dest_gpu_idx);
             return;
         }
@@ -555,99 +1108,520 @@ void Simulator::on_handoff_complete(const Event& event) {
 
     // Directly transition to decode on destination GPU (don't re-enter routing)
     req.state = RequestState::Decode;
-    req.start_decode_ms = now_ms_;
+    req.start_decode_ms = now();
     dest_gpu.active_decode++;
 
     touch_lru(req_idx, dest_gpu_idx);
-    record_event(EventType::StartDecode, req, dest_gpu_idx);
-    double duration = decode_duration_ms(req.gen_tokens, dest_gpu.active_decode, dest_gpu_idx);
-    pq_.push(Event{now_ms_ + duration, EventType::Finish, req_idx, dest_gpu_idx});
+    record_event(EventType::StartDecode, req_idx, dest_gpu_idx);
+    schedule_decode_finish(req_idx, dest_gpu_idx);
+}
+
+void Simulator::schedule_decode_finish(int req_idx, int gpu_idx) {
+    auto& req = requests_[req_idx];
+    auto& gpu = gpus_[gpu_idx];
+    double duration = 0.0;
+    double& spec_steps = requests_.spec[req_idx].steps;
+    spec_steps = 0.0;
+    if (cfg_.policy.spec_decode.enabled && start_speculation(req_idx, gpu_idx)) {
+        duration = spec_decode_duration_ms(req_idx, gpu.active_decode, gpu_idx, spec_steps);
+    } else {
+        duration = decode_duration_ms(req, gpu.active_decode, gpu_idx);
+    }
+    req.decode_end_ms = now() + duration;
+    push_event(Event{req.decode_end_ms, EventType::Finish, req_idx, gpu_idx});
+    schedule_kv_growth(req_idx, gpu_idx);
+}
+
+bool Simulator::start_speculation(int req_idx, int gpu_idx) {
+    auto& req = requests_[req_idx];
+    const auto& spec = cfg_.policy.spec_decode;
+    std::uint64_t& draft_kv_bytes = requests_.spec[req_idx].draft_kv_bytes;
+    draft_kv_bytes = 0;
+    if (spec.placement == DraftPlacement::Colocated) {
+        // The draft model keeps its own KV for prompt + output next to the target's
+        std::uint64_t need = static_cast<std::uint64_t>(req.prompt_tokens + req.gen_tokens) * spec.draft_kv_bytes_per_token;
+        bool ok = ensure_capacity_for(need, gpu_idx);
+        if (req.state != RequestState::Decode) return false;
+        if (!ok) {
+            ctr().spec_fallbacks++;
+            return false;
+        }
+        allocate_kv_bytes(req_idx, need, gpu_idx);
+        draft_kv_bytes = need;
+    }
+    return true;
+}
+
+double Simulator::spec_decode_duration_ms(int req_idx, int active_decode, int gpu_idx, double& steps) const {
+    const auto& req = requests_[req_idx];
+    const auto& spec = cfg_.policy.spec_decode;
+    const auto& gpu_cfg = cfg_.gpus[gpu_idx];
+    int cap = std::max(1, gpu_cfg.decode_sharing_cap);
+    int share = std::max(1, std::min(active_decode, cap));
+    double eff_tps = gpu_cfg.decode_tps * models_[req.model_idx].cfg.decode_speed * gpu_cfg.decode_efficiency;
+    if (eff_tps <= 0.0) return 0.0;
+    double token_ms = 1000.0 * share / eff_tps;  // one target step at the current batch share
+    int k = std::max(0, spec.draft_len);
+
+    // Verifying k extra tokens is nearly free when memory bound, and costs more as the batch fills
+    double verify_ms = token_ms * (1.0 + spec.verify_cost * k * static_cast<double>(share) / cap);
+    double draft_ms = 0.0;
+    if (spec.placement == DraftPlacement::Colocated) {
+        draft_ms = k * spec.draft_cost * token_ms;
+    } else {
+        draft_ms = k * spec.draft_cost * (1000.0 / eff_tps) + spec.remote_latency_ms;
+    }
+
+    // Expected tokens per step with per-token acceptance a and draft length k
+    double a = std::min(std::max(requests_.spec[req_idx].acceptance, 0.0), 1.0);
+    double tokens_per_step = (a >= 1.0) ? k + 1.0 : (1.0 - std::pow(a, k + 1)) / (1.0 - a);
+    steps = static_cast<double>(req.gen_tokens) / tokens_per_step;
+    return steps * (verify_ms + draft_ms);
+}
+
+void Simulator::init_spec_acceptance() {
+    const auto& spec = cfg_.policy.spec_decode;
+    if (!spec.enabled) return;
+    // Dedicated stream so enabling speculation leaves routing draws untouched
+    RNG gen = make_rng(cfg_.seed, cfg_.replication, RngStream::SpecAcceptance, 0x85ebca6bu);
+    double mean = std::min(std::max(spec.acceptance, 0.0), 1.0);
+    for (auto& req : requests_.spec) {
+        double a = mean;
+        if (spec.acceptance_dist == AcceptanceDist::Uniform) {
+            a = mean + spec.acceptance_spread * (2.0 * gen.uniform01() - 1.0);
+        } else if (spec.acceptance_dist == AcceptanceDist::Beta && mean > 0.0 && mean < 1.0) {
+            double kappa = std::max(spec.acceptance_concentration, 1e-3);
+            std::gamma_distribution<double> ga(mean * kappa, 1.0);
+            std::gamma_distribution<double> gb((1.0 - mean) * kappa, 1.0);
+            double x = gen.draw(ga);
+            double y = gen.draw(gb);
+            a = (x + y > 0.0) ? x / (x + y) : mean;
+        }
+        req.acceptance = std::min(std::max(a, 0.0), 1.0);
+    }
+}
+
+int Simulator::reserved_gen_on(int req_idx, int gpu_idx) const {
+    const auto& req = requests_[req_idx];
+    std::uint64_t per_token = kv_bytes_per_token(req);
+    if (per_token == 0) return req.gen_tokens;
+    std::uint64_t target_bytes = gpus_[gpu_idx].allocated_bytes[req_idx] - std::min(requests_.spec[req_idx].draft_kv_bytes, gpus_[gpu_idx].allocated_bytes[req_idx]);
+    std::uint64_t tokens = target_bytes / per_token;
+    return static_cast<int>(tokens) - req.prompt_tokens;
+}
+
+void Simulator::schedule_kv_growth(int req_idx, int gpu_idx) {
+    if (!cfg_.policy.predicted_reservation) return;
+    const auto& req = requests_[req_idx];
+    int reserved = std::max(0, reserved_gen_on(req_idx, gpu_idx));
+    if (reserved >= req.gen_tokens) return;
+    // Decode progresses linearly; grow when generation reaches the reserved tokens
+    double frac = static_cast<double>(reserved) / static_cast<double>(req.gen_tokens);
+    double when = req.start_decode_ms + (req.decode_end_ms - req.start_decode_ms) * frac;
+    push_event(Event{when, EventType::KvGrow, req_idx, gpu_idx});
+}
+
+void Simulator::on_kv_grow(const Event& event) {
+    int gpu_idx = event.gpu_index;
+    int req_idx = event.request_index;
+    auto& gpu = gpus_[gpu_idx];
+    auto& req = requests_[req_idx];
+    if (req.state != RequestState::Decode || req.decode_gpu != gpu_idx) {
+        return;
+    }
+    int grow = std::min(std::max(1, cfg_.policy.kv_growth_chunk_tokens), req.gen_tokens - reserved_gen_on(req_idx, gpu_idx));
+    if (grow <= 0) return;
+    std::uint64_t need = static_cast<std::uint64_t>(grow) * kv_bytes_per_token(req);
+    bool ok = ensure_capacity_for(need, gpu_idx);
+    // Making room may have evicted this request itself
+    if (req.state != RequestState::Decode) return;
+    if (!ok) {
+        ctr().kv_growth_failures++;
+        req.state = RequestState::Rejected;
+        release_tenant_slot(req);
+        cancel_pending_events(req_idx);
+        ctr().rejects++;
+        gpu.active_decode--;
+        record_event(EventType::Reject, req_idx, gpu_idx);
+        free_kv_bytes(req_idx, gpu.allocated_bytes[req_idx], gpu_idx);
+        drop_eviction_tracking(req_idx, gpu_idx);
+        try_start_prefill(gpu_idx);
+        return;
+    }
+    ctr().kv_growth_steps++;
+    allocate_kv_bytes(req_idx, need, gpu_idx);
+    touch_lru(req_idx, gpu_idx);
+    schedule_kv_growth(req_idx, gpu_idx);
 }
 
 void Simulator::on_finish(const Event& event) {
     int gpu_idx = event.gpu_index;
     auto& gpu = gpus_[gpu_idx];
     auto& req = requests_[event.request_index];
-    if (req.state == RequestState::Evicted || req.state == RequestState::Rejected || req.state == RequestState::Finished) {
+    if (request_left(req.state)) {
         return;
     }
     gpu.active_decode--;
     req.state = RequestState::Finished;
-    req.finish_ms = now_ms_;
-    tokens_generated_total_ += static_cast<std::uint64_t>(req.gen_tokens);
+    release_tenant_slot(req);
+    cancel_pending_events(event.request_index);
+    requests_.finish_ms[event.request_index] = now();
+    ctr().tokens_generated += static_cast<std::uint64_t>(req.gen_tokens);
 
     // Phase 8: Track per-GPU and cross-GPU metrics
     tokens_per_gpu_[gpu_idx] += static_cast<std::uint64_t>(req.gen_tokens);
+    double spec_steps = requests_.spec[event.request_index].steps;
+    if (spec_steps > 0.0) {
+        ctr().spec_steps += spec_steps;
+        ctr().spec_tokens += static_cast<std::uint64_t>(req.gen_tokens);
+    }
     requests_finished_per_gpu_[gpu_idx]++;
     if (req.prefill_gpu != req.decode_gpu) {
-        cross_gpu_decodes_++;
+        ctr().cross_gpu_decodes++;
     }
 
-    record_event(EventType::Finish, req, gpu_idx);
+    record_event(EventType::Finish, event.request_index, gpu_idx);
+    retain_session_kv(event.request_index, gpu_idx);
     free_kv_bytes(event.request_index, gpu.allocated_bytes[event.request_index], gpu_idx);
 
+    drop_eviction_tracking(event.request_index, gpu_idx);
+
+    try_start_prefill(gpu_idx);
+    try_dispatch_global_queue();
+}
+
+void Simulator::drop_eviction_tracking(int req_idx, int gpu_idx) {
+    auto& gpu = gpus_[gpu_idx];
     // Clean eviction tracking (lazy remove)
     if (cfg_.policy.eviction_policy == EvictionPolicy::LRU) {
-        if (gpu.lru_iters[event.request_index] != gpu.lru_list.end()) {
-            gpu.lru_list.erase(gpu.lru_iters[event.request_index]);
-            gpu.lru_iters[event.request_index] = gpu.lru_list.end();
+        if (gpu.lru_iters[req_idx] != gpu.lru_list.end()) {
+            gpu.lru_list.erase(gpu.lru_iters[req_idx]);
+            gpu.lru_iters[req_idx] = gpu.lru_list.end();
         }
     }
     // For FIFO, skip stale victims during eviction
     gpu.evict_queue.erase(
-        std::remove(gpu.evict_queue.begin(), gpu.evict_queue.end(), event.request_index),
+        std::remove(gpu.evict_queue.begin(), gpu.evict_queue.end(), req_idx),
         gpu.evict_queue.end());
+}
 
-    try_start_prefill(gpu_idx);
+void Simulator::init_sessions(const std::vector<Request>& trace) {
+    // Sessions are numbered in order of first appearance; turns without a column count up
+    sessions_.clear();
+    std::unordered_map<std::string, int> index;
+    std::vector<int> next_turn;
+    for (std::size_t i = 0; i < trace.size(); ++i) {
+        const Request& req = trace[i];
+        if (req.session.empty()) continue;
+        auto it = index.find(req.session);
+        if (it == index.end()) {
+            it = index.emplace(req.session, static_cast<int>(next_turn.size())).first;
+            next_turn.push_back(0);
+        }
+        int s = it->second;
+        requests_.session[i] = s;
+        if (req.turn < 0) requests_.turn[i] = next_turn[s];
+        next_turn[s] = std::max(next_turn[s], requests_.turn[i]) + 1;
+    }
+    sessions_.assign(next_turn.size(), SessionState{});
+}
+
+void Simulator::claim_session_kv(int req_idx, int gpu_idx) {
+    auto& req = requests_[req_idx];
+    req.cached_tokens = 0;
+    int s = requests_.session[req_idx];
+    if (s < 0) return;
+    auto& sess = sessions_[s];
+    sess.latest_req = req_idx;
+    bool followup = requests_.turn[req_idx] > 0;
+    if (followup) ctr().session_followups++;
+    if (sess.gpu < 0) return;
+    if (followup && sess.gpu == gpu_idx && sess.model_idx == req.model_idx) {
+        // At least one prompt token is always computed, so prefill never takes zero time
+        req.cached_tokens = std::min(sess.tokens, std::max(0, req.prompt_tokens - 1));
+        double tps = cfg_.gpus[gpu_idx].prefill_tps * models_[req.model_idx].cfg.prefill_speed;
+        ctr().session_hits++;
+        ctr().session_reused_tokens += static_cast<std::uint64_t>(req.cached_tokens);
+        ctr().session_prefill_saved_ms += 1000.0 * req.cached_tokens / tps;
+    }
+    // The new turn's own allocation covers the context from here on
+    drop_session_kv(s);
+}
+
+void Simulator::retain_session_kv(int req_idx, int gpu_idx) {
+    int s = requests_.session[req_idx];
+    if (cfg_.policy.session_kv_ttl_ms <= 0.0 || s < 0) return;
+    auto& sess = sessions_[s];
+    if (sess.latest_req != req_idx) return;  // a later turn is already placed
+    if (sess.gpu >= 0) drop_session_kv(s);
+    const auto& req = requests_[req_idx];
+    auto& gpu = gpus_[gpu_idx];
+    std::uint64_t per_token = kv_bytes_per_token(req);
+    std::uint64_t held = gpu.allocated_bytes[req_idx] - std::min(gpu.allocated_bytes[req_idx], requests_.spec[req_idx].draft_kv_bytes);
+    std::uint64_t bytes = std::min(held, static_cast<std::uint64_t>(req.prompt_tokens + req.gen_tokens) * per_token);
+    sess.gpu = gpu_idx;
+    sess.model_idx = req.model_idx;
+    sess.tokens = per_token > 0 ? static_cast<int>(bytes / per_token) : req.prompt_tokens + req.gen_tokens;
+    sess.bytes = bytes;
+    sess.expires_ms = now() + cfg_.policy.session_kv_ttl_ms;
+    sess.owner_req = req_idx;
+    sess.pos = gpu.retained_sessions.insert(gpu.retained_sessions.end(), s);
+    // Moved out of the request's allocation, which on_finish frees next
+    gpu.retained_bytes += bytes;
+    gpu.vram_used += bytes;
+    ctr().session_retained++;
+    push_event(Event{sess.expires_ms, EventType::SessionExpire, req_idx, gpu_idx});
+}
+
+void Simulator::drop_session_kv(int session_idx) {
+    auto& sess = sessions_[session_idx];
+    if (sess.gpu < 0) return;
+    auto& gpu = gpus_[sess.gpu];
+    gpu.retained_sessions.erase(sess.pos);
+    gpu.retained_bytes -= sess.bytes;
+    gpu.vram_used -= std::min(gpu.vram_used, sess.bytes);
+    sess.gpu = -1;
+    sess.owner_req = -1;
+    sess.tokens = 0;
+    sess.bytes = 0;
+}
+
+void Simulator::on_session_expire(const Event& event) {
+    int s = requests_.session[event.request_index];
+    auto& sess = sessions_[s];
+    // Stale when the KV was already claimed, dropped, or retained again by a later turn
+    if (sess.gpu != event.gpu_index || sess.owner_req != event.request_index) return;
+    drop_session_kv(s);
+    ctr().session_expired++;
+}
+
+int Simulator::prefer_session_gpu(int req_idx, int pick) const {
+    int s = requests_.session[req_idx];
+    if (s < 0) return pick;
+    const auto& sess = sessions_[s];
+    const auto& req = requests_[req_idx];
+    int home = sess.gpu;
+    if (home < 0 || home == pick || requests_.turn[req_idx] == 0 || sess.model_idx != req.model_idx) return pick;
+    // Go home unless its extra load outweighs the prefill the retained KV saves
+    int cached = std::min(sess.tokens, std::max(0, req.prompt_tokens - 1));
+    double saved_ms = 1000.0 * cached / (cfg_.gpus[home].prefill_tps * models_[req.model_idx].cfg.prefill_speed);
+    return score_gpu(home) - cfg_.policy.session_affinity_weight * saved_ms <= score_gpu(pick) ? home : pick;
+}
+
+void Simulator::init_timeouts() {
+    // Trace column, else the request class's timeout, else the policy default
+    double shortest = std::numeric_limits<double>::infinity();
+    double longest = 0.0;
+    for (std::size_t i = 0; i < requests_.size(); ++i) {
+        double& t = requests_.timeout_ms[i];
+        if (t <= 0.0) t = cfg_.policy.timeout_for_class(requests_[i].priority);
+        if (t <= 0.0) continue;
+        shortest = std::min(shortest, t);
+        longest = std::max(longest, t);
+    }
+    // The shortest timeout spans a fixed number of buckets, and the longest stays inside
+    // half a wheel turn; far shorter outliers just fire directly
+    constexpr double kBucketsPerTimeout = 16.0;
+    double tick = 0.0;
+    if (longest > 0.0) tick = std::max(shortest / kBucketsPerTimeout, longest / (TimerWheel::kSlots / 2));
+    timers_.reset(tick);
+    next_tick_ms_ = std::numeric_limits<double>::infinity();
+    expired_.clear();
+}
+
+void Simulator::arm_timeout(int req_idx) {
+    double timeout = requests_.timeout_ms[req_idx];
+    if (timeout > 0.0) arm_deadline(req_idx, requests_.arrival_ms[req_idx] + timeout);
+}
+
+void Simulator::arm_deadline(int req_idx, double deadline) {
+    if (!timers_.insert(deadline, req_idx, now())) {
+        push_event(Event{std::max(now(), deadline), EventType::Abandon, req_idx, -1});
+        return;
+    }
+    double wake = std::max(now(), timers_.bucket_start(timers_.bucket_of(deadline)));
+    if (wake < next_tick_ms_) {
+        next_tick_ms_ = wake;
+        push_event(Event{wake, EventType::TimerTick, -1, -1});
+    }
+}
+
+void Simulator::on_timer_tick(const Event& event) {
+    // Superseded by an earlier wake-up that already rescheduled
+    if (event.time_ms < next_tick_ms_) return;
+    std::int64_t b = timers_.next_bucket();
+    for (; b >= 0 && timers_.bucket_start(b) <= now(); b = timers_.next_bucket()) {
+        timers_.expand(b, expired_);
+        for (const auto& t : expired_) {
+            if (request_left(requests_[t.req_idx].state)) continue;
+            push_event(Event{std::max(now(), t.deadline_ms), EventType::Abandon, t.req_idx, -1});
+        }
+    }
+    next_tick_ms_ = std::numeric_limits<double>::infinity();
+    if (b >= 0) {
+        next_tick_ms_ = timers_.bucket_start(b);
+        push_event(Event{next_tick_ms_, EventType::TimerTick, -1, -1});
+    }
+}
+
+void Simulator::on_abandon(const Event& event) {
+    if (request_left(requests_[event.request_index].state)) return;
+    abandon_request(event.request_index);
+}
+
+void Simulator::abandon_request(int req_idx) {
+    auto& req = requests_[req_idx];
+    int num_gpus = static_cast<int>(gpus_.size());
+    int slot_gpu = -1;  // GPU whose prefill/decode slot this frees
+    int log_gpu = -1;
+    if (req.state == RequestState::Arrived) {
+        global_queue_.erase(req_idx);
+        abandoned_queued_++;
+    } else if (req.state == RequestState::Queued) {
+        // Not in a prefill queue means a StartPrefill is pending; it gives the slot back
+        // once it finds the request gone
+        for (auto& gpu : gpus_) {
+            if (gpu.prefill_queue.erase(req_idx)) {
+                gpu.queued_prompt_tokens -= static_cast<std::uint64_t>(req.prompt_tokens);
+                break;
+            }
+        }
+        abandoned_queued_++;
+    } else if (req.state == RequestState::Prefill) {
+        double started = requests_.start_prefill_ms[req_idx];
+        double prefill_ms = prefill_duration_ms(req, req.prefill_gpu);
+        if (now() < started + prefill_ms) {
+            slot_gpu = req.prefill_gpu;
+            gpus_[slot_gpu].active_prefill--;
+            prefill_ms = now() - started;
+        }
+        // Otherwise prefill is done and the KV is on its way to the decode GPU
+        abandoned_prefill_++;
+        abandoned_prefill_ms_ += prefill_ms;
+        log_gpu = req.prefill_gpu;
+    } else {
+        abandoned_decode_++;
+        abandoned_prefill_ms_ += prefill_duration_ms(req, req.prefill_gpu);
+        log_gpu = req.decode_gpu;
+        // A decode in progress holds its slot on the one GPU left holding its KV; before
+        // schedule_decode_finish (a retry handing off elsewhere) it holds none
+        if (req.decode_end_ms > now()) {
+            for (int g = 0; g < num_gpus; ++g) {
+                if (gpus_[g].allocated_bytes[req_idx] > 0) log_gpu = g;
+            }
+            slot_gpu = log_gpu;
+            gpus_[slot_gpu].active_decode--;
+            double frac = (now() - req.start_decode_ms) / (req.decode_end_ms - req.start_decode_ms);
+            abandoned_decode_tokens_ += frac * req.gen_tokens;
+        }
+    }
+
+    for (int g = 0; g < num_gpus; ++g) {
+        auto& gpu = gpus_[g];
+        if (gpu.allocated_bytes[req_idx] == 0) continue;
+        if (log_gpu < 0) log_gpu = g;
+        free_kv_bytes(req_idx, gpu.allocated_bytes[req_idx], g);
+        drop_eviction_tracking(req_idx, g);
+    }
+    req.state = RequestState::Abandoned;
+    release_tenant_slot(req);
+    cancel_pending_events(req_idx);
+    record_event(EventType::Abandon, req_idx, log_gpu);
+    if (slot_gpu >= 0) try_start_prefill(slot_gpu);
     try_dispatch_global_queue();
 }
 
-void Simulator::record_event(EventType type, const Request& req, int gpu_idx) {
-    events_.push_back(EventRecord{now_ms_, type, req.id, gpu_idx});
+void Simulator::record_event(EventType type, int req_idx, int gpu_idx) {
+    EventRecord r{now(), type, requests_.id[req_idx], gpu_idx, req_idx};
+    if (active_lane_) {
+        active_lane_->records.push_back(std::move(r));
+    } else {
+        log_record(std::move(r));
+    }
+}
+
+void Simulator::log_record(EventRecord r) {
+    if (trace_writer_) trace_writer_->add_event(r);
+    if (!flight_.enabled()) {
+        events_.push_back(std::move(r));
+        return;
+    }
+    if (r.type == EventType::StartDecode) flight_.note_ttft(r.time_ms - requests_.arrival_ms[r.request_index]);
+    flight_.record(std::move(r));
+}
+
+void Simulator::set_trace_writer(ChromeTraceWriter* writer) {
+    trace_writer_ = writer;
+    if (!writer) return;
+    const auto& records = events();
+    std::size_t s = 0;
+    for (const auto& e : records) {
+        for (; s < samples_.size() && samples_[s].time_ms <= e.time_ms; ++s) writer->add_sample(samples_[s]);
+        writer->add_event(e);
+    }
+    for (; s < samples_.size(); ++s) writer->add_sample(samples_[s]);
 }
 
 void Simulator::sample_until(double target_time_ms) {
+    KV_PROF_TIMER(perf_.sampling_ns);
     while (next_sample_ms_ <= target_time_ms) {
         TimeseriesSample s;
         s.time_ms = next_sample_ms_;
-        for (const auto& gpu : gpus_) {
-            s.vram_used += gpu.vram_used;
-            s.active_prefill += gpu.active_prefill;
-            s.active_decode += gpu.active_decode;
-            s.queue_depth += static_cast<int>(gpu.prefill_queue.size());
-            s.vram_per_gpu.push_back(gpu.vram_used);  // Phase 8: Per-GPU VRAM
+        for (int g = 0; g < static_cast<int>(gpus_.size()); ++g) {
+            GpuLoad load = sample_view_ ? (*sample_view_)[g] : load_of(g);
+            s.vram_used += load.vram_used;
+            s.active_prefill += load.active_prefill;
+            s.active_decode += load.active_decode;
+            s.queue_depth += load.queue_depth;
+            s.vram_per_gpu.push_back(load.vram_used);  // Phase 8: Per-GPU VRAM
         }
         s.global_queue_depth = static_cast<int>(global_queue_.size());  // Phase 8: Global queue
-        s.tokens_generated_delta = tokens_generated_total_ - last_tokens_sampled_;
-        s.rejects_delta = rejects_total_ - last_rejects_sampled_;
+        s.tokens_generated_delta = ctr_.tokens_generated - last_tokens_sampled_;
+        s.rejects_delta = ctr_.rejects - last_rejects_sampled_;
         samples_.push_back(s);
-        last_tokens_sampled_ = tokens_generated_total_;
-        last_rejects_sampled_ = rejects_total_;
+        if (trace_writer_) trace_writer_->add_sample(s);
+        if (flight_.enabled()) flight_.check(s);
+        last_tokens_sampled_ = ctr_.tokens_generated;
+        last_rejects_sampled_ = ctr_.rejects;
         next_sample_ms_ += cfg_.timeseries_dt_ms;
     }
     // Ensure we capture the tail interval up to target_time_ms (even if it is not on the sampling grid).
     if (samples_.empty() || samples_.back().time_ms < target_time_ms) {
         TimeseriesSample s;
         s.time_ms = target_time_ms;
-        for (const auto& gpu : gpus_) {
-            s.vram_used += gpu.vram_used;
-            s.active_prefill += gpu.active_prefill;
-            s.active_decode += gpu.active_decode;
-            s.queue_depth += static_cast<int>(gpu.prefill_queue.size());
-            s.vram_per_gpu.push_back(gpu.vram_used);  // Phase 8: Per-GPU VRAM
+        for (int g = 0; g < static_cast<int>(gpus_.size()); ++g) {
+            GpuLoad load = sample_view_ ? (*sample_view_)[g] : load_of(g);
+            s.vram_used += load.vram_used;
+            s.active_prefill += load.active_prefill;
+            s.active_decode += load.active_decode;
+            s.queue_depth += load.queue_depth;
+            s.vram_per_gpu.push_back(load.vram_used);  // Phase 8: Per-GPU VRAM
         }
         s.global_queue_depth = static_cast<int>(global_queue_.size());  // Phase 8: Global queue
-        s.tokens_generated_delta = tokens_generated_total_ - last_tokens_sampled_;
-        s.rejects_delta = rejects_total_ - last_rejects_sampled_;
+        s.tokens_generated_delta = ctr_.tokens_generated - last_tokens_sampled_;
+        s.rejects_delta = ctr_.rejects - last_rejects_sampled_;
         samples_.push_back(s);
-        last_tokens_sampled_ = tokens_generated_total_;
-        last_rejects_sampled_ = rejects_total_;
+        if (trace_writer_) trace_writer_->add_sample(s);
+        if (flight_.enabled()) flight_.check(s);
+        last_tokens_sampled_ = ctr_.tokens_generated;
+        last_rejects_sampled_ = ctr_.rejects;
     }
 }
 
+Simulator::GpuLoad Simulator::load_of(int gpu_idx) const {
+    const auto& gpu = gpus_[gpu_idx];
+    return GpuLoad{gpu.vram_used, gpu.active_prefill, gpu.active_decode, static_cast<int>(gpu.prefill_queue.size())};
+}
+
 bool Simulator::ensure_capacity_for(std::uint64_t bytes_needed, int gpu_idx) {
     auto& gpu = gpus_[gpu_idx];
     if (gpu.vram_used + bytes_needed <= cfg_.gpus[gpu_idx].vram_bytes) return true;
+    // Retained session KV is only a cache: drop it, oldest first, before anything live
+    while (!gpu.retained_sessions.empty() && gpu.vram_used + bytes_needed > cfg_.gpus[gpu_idx].vram_bytes) {
+        drop_session_kv(gpu.retained_sessions.front());
+        ctr().session_pressure_drops++;
+    }
+    if (gpu.vram_used + bytes_needed <= cfg_.gpus[gpu_idx].vram_bytes) return true;
     if (cfg_.policy.memory_pressure_policy == MemoryPressurePolicy::Reject) return false;
 
     //evict until fits or no victims 
@@ -664,7 +1638,7 @@ bool Simulator::evict_one(int gpu_idx) {
         while (!gpu.evict_queue.empty()) {
             int cand = gpu.evict_queue.front();
             const auto& req = requests_[cand];
-            if (req.state == RequestState::Rejected || req.state == RequestState::Evicted || req.state == RequestState::Finished) {
+            if (request_left(req.state)) {
                 gpu.evict_queue.pop_front();
                 continue;
             }
@@ -680,7 +1654,7 @@ bool Simulator::evict_one(int gpu_idx) {
         gpu.lru_iters[victim] = gpu.lru_list.end();
     }
     auto& req = requests_[victim];
-    if (req.state == RequestState::Rejected || req.state == RequestState::Evicted || req.state == RequestState::Finished) {
+    if (request_left(req.state)) {
         return false; // skip invalid victim
     }
     // Adjust active counters and queue bookkeeping
@@ -689,14 +1663,17 @@ bool Simulator::evict_one(int gpu_idx) {
     } else if (req.state == RequestState::Decode) {
         if (gpu.active_decode > 0) gpu.active_decode--;
     } else if (req.state == RequestState::Queued) {
-        // remove from prefill_queue_ if present
-        gpu.prefill_queue.erase(
-            std::remove(gpu.prefill_queue.begin(), gpu.prefill_queue.end(), victim),
-            gpu.prefill_queue.end());
+        // remove from prefill_queue if present
+        if (gpu.prefill_queue.erase(victim)) {
+            gpu.queued_prompt_tokens -= static_cast<std::uint64_t>(req.prompt_tokens);
+        }
     }
     free_kv_bytes(victim, gpu.allocated_bytes[victim], gpu_idx);
     req.state = RequestState::Evicted;
-    record_event(EventType::Evict, req, gpu_idx);
+    release_tenant_slot(req);
+    cancel_pending_events(victim);
+    ctr().evictions++;
+    record_event(EventType::Evict, victim, gpu_idx);
     // After freeing, try to start more work
     try_start_prefill(gpu_idx);
     return true;
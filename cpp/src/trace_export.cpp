@@ -0,0 +1,231 @@
+#include "trace_export.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include "io_output.hpp"
+
+namespace {
+
+constexpr int kClusterPid = 0;
+
+int gpu_pid(int gpu) { return gpu + 1; }
+
+// Trace-event timestamps are microseconds; fixed notation keeps long runs exact
+void put_us(std::ostream& os, double ms) {
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%.3f", ms * 1000.0);
+    os << buf;
+}
+
+void put_string(std::ostream& os, const std::string& s) {
+    os << '"';
+    for (char c : s) {
+        if (c == '"' || c == '\\') os << '\\';
+        os << c;
+    }
+    os << '"';
+}
+
+}  // namespace
+
+ChromeTraceWriter::ChromeTraceWriter(std::ostream& os, int num_gpus)
+    : os_(os), gpus_(static_cast<std::size_t>(std::max(0, num_gpus))) {
+    os_ << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    begin_record() << "{\"ph\":\"M\",\"name\":\"process_name\",\"pid\":" << kClusterPid
+                   << ",\"args\":{\"name\":\"cluster\"}}";
+    for (int g = 0; g < num_gpus; ++g) {
+        begin_record() << "{\"ph\":\"M\",\"name\":\"process_name\",\"pid\":" << gpu_pid(g)
+                       << ",\"args\":{\"name\":\"GPU " << g << "\"}}";
+        begin_record() << "{\"ph\":\"M\",\"name\":\"process_sort_index\",\"pid\":" << gpu_pid(g)
+                       << ",\"args\":{\"sort_index\":" << gpu_pid(g) << "}}";
+    }
+}
+
+ChromeTraceWriter::~ChromeTraceWriter() {
+    if (!finished_) finish();
+}
+
+std::ostream& ChromeTraceWriter::begin_record() {
+    if (!first_) os_ << ",\n";
+    first_ = false;
+    return os_;
+}
+
+void ChromeTraceWriter::add_event(const EventRecord& e) {
+    last_ms_ = std::max(last_ms_, e.time_ms);
+    int gpu = e.gpu_index;
+    if (gpu < 0 || gpu >= static_cast<int>(gpus_.size())) return;
+    switch (e.type) {
+        // Arrival is logged when a GPU takes the request (directly or from the global queue)
+        case EventType::Arrival: enter(e.request_id, Phase::Queued, gpu, e.time_ms); break;
+        case EventType::StartPrefill: enter(e.request_id, Phase::Prefill, gpu, e.time_ms); break;
+        case EventType::HandoffStart: enter(e.request_id, Phase::Handoff, gpu, e.time_ms); break;
+        case EventType::StartDecode: enter(e.request_id, Phase::Decode, gpu, e.time_ms); break;
+        case EventType::Finish: leave(e.request_id, e.time_ms); break;
+        case EventType::Reject:
+        case EventType::Evict:
+        case EventType::Abandon: {
+            int slot = leave(e.request_id, e.time_ms);
+            auto& os = begin_record();
+            os << "{\"ph\":\"i\",\"name\":\"" << event_type_str(e.type) << "\",\"cat\":\"request\",\"pid\":" << gpu_pid(gpu);
+            if (slot >= 0) {
+                os << ",\"tid\":" << slot << ",\"s\":\"t\"";
+            } else {
+                os << ",\"s\":\"p\"";
+            }
+            os << ",\"ts\":";
+            put_us(os, e.time_ms);
+            os << ",\"args\":{\"request\":";
+            put_string(os, e.request_id);
+            os << "}}";
+            break;
+        }
+        default: break;
+    }
+}
+
+void ChromeTraceWriter::add_sample(const TimeseriesSample& s) {
+    last_ms_ = std::max(last_ms_, s.time_ms);
+    // Counters only change the track when their value does
+    if (s.queue_depth != last_queue_depth_ || s.global_queue_depth != last_global_depth_) {
+        last_queue_depth_ = s.queue_depth;
+        last_global_depth_ = s.global_queue_depth;
+        auto& os = begin_record();
+        os << "{\"ph\":\"C\",\"name\":\"queue_depth\",\"pid\":" << kClusterPid << ",\"ts\":";
+        put_us(os, s.time_ms);
+        os << ",\"args\":{\"gpu_queues\":" << s.queue_depth << ",\"global\":" << s.global_queue_depth << "}}";
+    }
+    std::size_t n = std::min(gpus_.size(), s.vram_per_gpu.size());
+    for (std::size_t g = 0; g < n; ++g) {
+        if (s.vram_per_gpu[g] == gpus_[g].last_vram) continue;
+        gpus_[g].last_vram = s.vram_per_gpu[g];
+        auto& os = begin_record();
+        os << "{\"ph\":\"C\",\"name\":\"vram\",\"pid\":" << gpu_pid(static_cast<int>(g)) << ",\"ts\":";
+        put_us(os, s.time_ms);
+        os << ",\"args\":{\"GB\":" << static_cast<double>(s.vram_per_gpu[g]) / 1e9 << "}}";
+    }
+}
+
+void ChromeTraceWriter::finish() {
+    if (finished_) return;
+    finished_ = true;
+    // Sorted so the output does not depend on hash order
+    std::vector<const std::string*> ids;
+    ids.reserve(open_.size());
+    for (const auto& kv : open_) ids.push_back(&kv.first);
+    std::sort(ids.begin(), ids.end(), [](const std::string* a, const std::string* b) { return *a < *b; });
+    for (const std::string* id : ids) write_span(*id, open_.at(*id), last_ms_);
+    open_.clear();
+    os_ << "\n]}\n";
+}
+
+void ChromeTraceWriter::enter(const std::string& id, Phase phase, int gpu, double t_ms) {
+    int slot = -1;
+    int from_gpu = -1;
+    auto it = open_.find(id);
+    if (it != open_.end()) {
+        OpenSpan& prev = it->second;
+        write_span(id, prev, t_ms);
+        gpus_[prev.gpu].count[static_cast<int>(prev.phase)]--;
+        // A request keeps its slot while it stays on the same GPU
+        if (prev.gpu == gpu) {
+            slot = prev.slot;
+        } else {
+            release_slot(prev.gpu, prev.slot);
+            write_counts(prev.gpu, t_ms);
+            if (phase == Phase::Handoff) from_gpu = prev.gpu;
+        }
+    }
+    if (slot < 0 && phase != Phase::Queued) slot = acquire_slot(gpu);
+    open_[id] = OpenSpan{phase, gpu, slot, from_gpu, t_ms};
+    gpus_[gpu].count[static_cast<int>(phase)]++;
+    write_counts(gpu, t_ms);
+}
+
+int ChromeTraceWriter::leave(const std::string& id, double t_ms) {
+    auto it = open_.find(id);
+    if (it == open_.end()) return -1;
+    OpenSpan prev = it->second;
+    open_.erase(it);
+    write_span(id, prev, t_ms);
+    gpus_[prev.gpu].count[static_cast<int>(prev.phase)]--;
+    write_counts(prev.gpu, t_ms);
+    release_slot(prev.gpu, prev.slot);
+    return prev.slot;
+}
+
+void ChromeTraceWriter::write_span(const std::string& id, const OpenSpan& span, double end_ms) {
+    static const char* const kNames[] = {"queued", "prefill", "handoff", "decode"};
+    if (span.slot < 0) return;
+    auto& os = begin_record();
+    os << "{\"ph\":\"X\",\"name\":\"" << kNames[static_cast<int>(span.phase)] << "\",\"cat\":\"request\",\"pid\":"
+       << gpu_pid(span.gpu) << ",\"tid\":" << span.slot << ",\"ts\":";
+    put_us(os, span.start_ms);
+    os << ",\"dur\":";
+    put_us(os, std::max(0.0, end_ms - span.start_ms));
+    os << ",\"args\":{\"request\":";
+    put_string(os, id);
+    if (span.from_gpu >= 0) os << ",\"from_gpu\":" << span.from_gpu;
+    os << "}}";
+}
+
+void ChromeTraceWriter::write_counts(int gpu, double t_ms) {
+    const auto& g = gpus_[gpu];
+    auto& os = begin_record();
+    os << "{\"ph\":\"C\",\"name\":\"requests\",\"pid\":" << gpu_pid(gpu) << ",\"ts\":";
+    put_us(os, t_ms);
+    os << ",\"args\":{\"queued\":" << g.count[0] << ",\"prefill\":" << g.count[1] << ",\"handoff\":" << g.count[2]
+       << ",\"decode\":" << g.count[3] << "}}";
+}
+
+int ChromeTraceWriter::acquire_slot(int gpu) {
+    auto& g = gpus_[gpu];
+    if (!g.free_slots.empty()) {
+        std::pop_heap(g.free_slots.begin(), g.free_slots.end(), std::greater<int>());
+        int slot = g.free_slots.back();
+        g.free_slots.pop_back();
+        return slot;
+    }
+    int slot = g.next_slot++;
+    begin_record() << "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":" << gpu_pid(gpu) << ",\"tid\":" << slot
+                   << ",\"args\":{\"name\":\"slot " << slot << "\"}}";
+    begin_record() << "{\"ph\":\"M\",\"name\":\"thread_sort_index\",\"pid\":" << gpu_pid(gpu) << ",\"tid\":" << slot
+                   << ",\"args\":{\"sort_index\":" << slot << "}}";
+    return slot;
+}
+
+void ChromeTraceWriter::release_slot(int gpu, int slot) {
+    if (slot < 0) return;
+    auto& g = gpus_[gpu];
+    g.free_slots.push_back(slot);
+    std::push_heap(g.free_slots.begin(), g.free_slots.end(), std::greater<int>());
+}
+
+void format_chrome_trace(std::ostream& os, const std::vector<EventRecord>& events,
+                         const std::vector<TimeseriesSample>& samples, int num_gpus) {
+    ChromeTraceWriter w(os, num_gpus);
+    std::size_t s = 0;
+    for (const auto& e : events) {
+        for (; s < samples.size() && samples[s].time_ms <= e.time_ms; ++s) w.add_sample(samples[s]);
+        w.add_event(e);
+    }
+    for (; s < samples.size(); ++s) w.add_sample(samples[s]);
+    w.finish();
+}
+
+bool write_chrome_trace(const std::string& path, const std::vector<EventRecord>& events,
+                        const std::vector<TimeseriesSample>& samples, int num_gpus, std::string& err) {
+    std::ofstream ofs(path);
+    if (!ofs.is_open()) {
+        err = "cannot open chrome trace " + path;
+        return false;
+    }
+    format_chrome_trace(ofs, events, samples, num_gpus);
+    ofs.flush();
+    if (!ofs) {
+        err = "failed writing chrome trace " + path;
+        return false;
+    }
+    return true;
+}
@@ -1,13 +1,17 @@
+import csv
+import json
 import os
 import subprocess
+import sys
 import tempfile
+import threading
 import uuid
 from pathlib import Path
 from typing import Optional, Dict, Any
 
-from fastapi import FastAPI, HTTPException
+from fastapi import BackgroundTasks, FastAPI, HTTPException
 from fastapi.middleware.cors import CORSMiddleware
-from fastapi.responses import FileResponse, PlainTextResponse, JSONResponse
+from fastapi.responses import FileResponse, PlainTextResponse, JSONResponse, StreamingResponse
 from pydantic import BaseModel
 
 
@@ -15,6 +19,22 @@ ROOT = Path(__file__).resolve().parents[2]  # repo root
 BIN_DEFAULT = ROOT / "cpp" / "build" / "kv_sim"
 RUNS_ROOT = ROOT / "runs" / "api"
 
+# In-process simulator (cpp/bindings, built with -DKV_SIM_BUILD_PYTHON=ON). When it cannot
+# be imported, or KV_SIM_NATIVE=0, /run falls back to spawning the kv_sim binary.
+sys.path.insert(0, os.environ.get("KV_SIM_PYMODULE_DIR", str(ROOT / "cpp" / "build")))
+try:
+    import kv_sim_native
+except ImportError:
+    kv_sim_native = None
+USE_NATIVE = kv_sim_native is not None and os.environ.get("KV_SIM_NATIVE", "1") != "0"
+
+# Content-addressed result cache shared with the CLI (--cache-dir); KV_SIM_CACHE=0 disables
+CACHE_DIR = None if os.environ.get("KV_SIM_CACHE", "1") == "0" else \
+    str(ROOT / os.environ.get("KV_SIM_CACHE_DIR", "runs/cache"))
+
+# Events per native step of a live run; small enough that rows and cancels are prompt
+STREAM_STEP_EVENTS = int(os.environ.get("KV_SIM_STREAM_STEP_EVENTS", "20000"))
+
 
 class RunRequest(BaseModel):
     trace_path: Optional[str] = None       
@@ -42,13 +62,14 @@ def resolve_path(p: str) -> Path:
     return cp
 
 
+def config_text(config_options: Dict[str, Any]) -> str:
+    return "\n".join(f"{k} {v}" for k, v in config_options.items())
+
+
 def write_config_temp(config_options: Dict[str, Any]) -> Path:
-    lines = []
-    for k, v in config_options.items():
-        lines.append(f"{k} {v}")
     fd, tmp_path = tempfile.mkstemp(suffix=".txt", prefix="kv_cfg_")
     with os.fdopen(fd, "w") as f:
-        f.write("\n".join(lines))
+        f.write(config_text(config_options))
     return Path(tmp_path)
 
 
@@ -60,8 +81,117 @@ def write_trace_temp(content: str, name: str = "trace.txt") -> Path:
     return Path(tmp_path)
 
 
+def run_response(run_id: str, out_dir: Path, cached: bool = False) -> Dict[str, Any]:
+    summary_file = out_dir / "summary.json"
+    if not summary_file.exists():
+        raise HTTPException(status_code=500, detail="summary.json not produced")
+    with open(summary_file, "r") as f:
+        summary = json.load(f)
+    return response_body(run_id, out_dir, summary, cached)
+
+
+def response_body(run_id: str, out_dir: Path, summary: Dict[str, Any], cached: bool = False) -> Dict[str, Any]:
+    # if out_dir under RUNS_ROOT, expose relative path
+    if str(out_dir).startswith(str(RUNS_ROOT)):
+        run_dir_rel = str(out_dir.relative_to(ROOT))
+    else:
+        run_dir_rel = str(out_dir)
+
+    return {
+        "run_id": run_id,
+        "run_dir": run_dir_rel,
+        "summary": summary,
+        "summary_url": f"/runs/{run_id}/summary",
+        "timeseries_url": f"/runs/{run_id}/timeseries",
+        "events_url": f"/runs/{run_id}/events",
+        "cached": cached,
+    }
+
+
+def native_kwargs(req: RunRequest) -> Dict[str, Any]:
+    kwargs = {"config_text": config_text(req.config_options or {}), "seed": req.seed}
+    if req.trace_content:
+        kwargs["trace_text"] = req.trace_content
+    elif req.trace_path:
+        trace_path = resolve_path(req.trace_path)
+        if not trace_path.exists():
+            raise HTTPException(status_code=400, detail=f"Trace not found: {trace_path}")
+        kwargs["trace_path"] = str(trace_path)
+    else:
+        raise HTTPException(status_code=400, detail="Provide trace_content or trace_path")
+    return kwargs
+
+
+def native_cache_fetch(kwargs: Dict[str, Any], out_dir: Path) -> Optional[str]:
+    """Returns the run's cache key, or None when out_dir was filled from the cache."""
+    if CACHE_DIR is None:
+        return ""
+    key = kv_sim_native.cache_key(**kwargs)
+    return None if kv_sim_native.cache_fetch(CACHE_DIR, key, str(out_dir)) else key
+
+
+class PendingOutputs:
+    """A native run's files, written once the response is sent or when first asked for."""
+
+    def __init__(self, result, out_dir: Path, cache_key: str):
+        self.result = result
+        self.out_dir = out_dir
+        self.cache_key = cache_key
+        self.written = False
+        self.lock = threading.Lock()
+
+    def write(self):
+        with self.lock:
+            if self.written:
+                return
+            self.out_dir.parent.mkdir(parents=True, exist_ok=True)
+            self.result.write_outputs(str(self.out_dir))
+            if self.cache_key:
+                kv_sim_native.cache_store(CACHE_DIR, self.cache_key, str(self.out_dir))
+            self.written = True
+
+
+PENDING_OUTPUTS: Dict[str, PendingOutputs] = {}
+PENDING_OUTPUTS_LOCK = threading.Lock()
+
+
+def flush_outputs(run_id: str):
+    with PENDING_OUTPUTS_LOCK:
+        pending = PENDING_OUTPUTS.get(run_id)
+    if pending is None:
+        return
+    try:
+        pending.write()
+    finally:
+        with PENDING_OUTPUTS_LOCK:
+            PENDING_OUTPUTS.pop(run_id, None)
+
+
+def run_native(req: RunRequest, run_id: str, out_dir: Path, background_tasks: BackgroundTasks) -> Dict[str, Any]:
+    # No temp files and no process spawn; the GIL is released while the simulation runs.
+    # The response comes straight from the result; files follow in the background.
+    kwargs = native_kwargs(req)
+    try:
+        key = native_cache_fetch(kwargs, out_dir)
+        if key is None:
+            return run_response(run_id, out_dir, cached=True)
+        result = kv_sim_native.run_trace(**kwargs)
+        summary = result.summary
+    except (RuntimeError, ValueError) as e:
+        raise HTTPException(status_code=500, detail=str(e))
+    with PENDING_OUTPUTS_LOCK:
+        PENDING_OUTPUTS[run_id] = PendingOutputs(result, out_dir, key)
+    background_tasks.add_task(flush_outputs, run_id)
+    return response_body(run_id, out_dir, summary)
+
+
 @app.post("/run")
-def run_sim(req: RunRequest):
+def run_sim(req: RunRequest, background_tasks: BackgroundTasks):
+    if USE_NATIVE:
+        run_id = uuid.uuid4().hex[:8]
+        out_dir = resolve_path(req.out_dir) if req.out_dir else RUNS_ROOT / run_id
+        return run_native(req, run_id, out_dir, background_tasks)
+
     bin_path = os.environ.get("KV_SIM_BIN", str(BIN_DEFAULT))
     bin_path = resolve_path(bin_path)
     if not bin_path.exists():
@@ -92,38 +222,15 @@ def run_sim(req: RunRequest):
             cmd.extend(["--config", str(config_path)])
         if req.seed is not None:
             cmd.extend(["--seed", str(req.seed)])
+        if CACHE_DIR is not None:
+            cmd.extend(["--cache-dir", CACHE_DIR])
 
         proc = subprocess.run(cmd, capture_output=True, text=True)
         if proc.returncode != 0:
             detail = proc.stderr or proc.stdout or "simulator failed"
             raise HTTPException(status_code=500, detail=detail)
 
-        summary_file = out_dir / "summary.json"
-        ts_file = out_dir / "timeseries.csv"
-        events_file = out_dir / "events.jsonl"
-        if not summary_file.exists():
-            raise HTTPException(status_code=500, detail="summary.json not produced")
-
-        import json
-        with open(summary_file, "r") as f:
-            summary = json.load(f)
-
-        base_url = "/runs/api"
-        # if out_dir under RUNS_ROOT, expose relative path
-        if str(out_dir).startswith(str(RUNS_ROOT)):
-            rel = out_dir.relative_to(ROOT)
-            run_dir_rel = str(rel)
-        else:
-            run_dir_rel = str(out_dir)
-
-        return {
-            "run_id": run_id,
-            "run_dir": run_dir_rel,
-            "summary": summary,
-            "summary_url": f"/runs/{run_id}/summary",
-            "timeseries_url": f"/runs/{run_id}/timeseries",
-            "events_url": f"/runs/{run_id}/events",
-        }
+        return run_response(run_id, out_dir, cached=proc.stdout.startswith("Cache hit"))
     finally:
         if config_path and config_path.exists():
             try:
@@ -138,6 +245,11 @@ def run_sim(req: RunRequest):
 
 
 def _resolve_run_file(run_id: str, filename: str) -> Path:
+    # A native run that just responded may not have written its files yet
+    try:
+        flush_outputs(run_id)
+    except (RuntimeError, OSError) as e:
+        raise HTTPException(status_code=500, detail=str(e))
     p = RUNS_ROOT / run_id / filename
     if not p.exists():
         raise HTTPException(status_code=404, detail=f"{filename} not found for run {run_id}")
@@ -161,3 +273,202 @@ def get_events(run_id: str):
     p = _resolve_run_file(run_id, "events.jsonl")
     return PlainTextResponse(p.read_text(), media_type="application/jsonl")
 
+
+
+# ---------------------------------------------------------------- live runs
+#
+# POST /runs starts a simulation in a background thread and returns at once. The client
+# follows GET /runs/{id}/stream (server-sent events): "timeseries" events carry new rows as
+# they are produced, then one "done" (same body as POST /run) or "error" event closes the
+# stream. POST /runs/{id}/cancel stops the run early; its outputs cover the time simulated.
+
+
+class LiveRun:
+    def __init__(self, run_id: str, out_dir: Path):
+        self.run_id = run_id
+        self.out_dir = out_dir
+        self.rows: list = []
+        self.done = False
+        self.result: Optional[Dict[str, Any]] = None
+        self.error: Optional[str] = None
+        self.cancel_requested = False
+        self.session = None  # native Session, cancelled directly
+        self.proc = None     # subprocess fallback, terminated on cancel
+        self.cond = threading.Condition()
+
+    def push_rows(self, rows: list):
+        if not rows:
+            return
+        with self.cond:
+            self.rows.extend(rows)
+            self.cond.notify_all()
+
+    def finish(self, result: Optional[Dict[str, Any]] = None, error: Optional[str] = None):
+        with self.cond:
+            self.result = result
+            self.error = error
+            self.done = True
+            self.cond.notify_all()
+
+
+LIVE_RUNS: Dict[str, LiveRun] = {}
+LIVE_RUNS_LOCK = threading.Lock()
+MAX_LIVE_RUNS = 256  # finished runs nobody streamed are dropped beyond this
+
+
+def _live_native(req: RunRequest, live: LiveRun):
+    kwargs = native_kwargs(req)
+    key = native_cache_fetch(kwargs, live.out_dir)
+    if key is None:
+        live.push_rows(_read_timeseries_rows(live.out_dir / "timeseries.csv"))
+        result = run_response(live.run_id, live.out_dir, cached=True)
+        result["cancelled"] = False
+        return result
+    session = kv_sim_native.Session(**kwargs)
+    live.session = session
+    if live.cancel_requested:
+        session.cancel()
+    while session.run_for(STREAM_STEP_EVENTS):
+        live.push_rows(session.timeseries_rows(len(live.rows)))
+    live.push_rows(session.timeseries_rows(len(live.rows)))
+    live.out_dir.parent.mkdir(parents=True, exist_ok=True)
+    session.write_outputs(str(live.out_dir))
+    if key and not session.cancelled:
+        kv_sim_native.cache_store(CACHE_DIR, key, str(live.out_dir))
+    result = response_body(live.run_id, live.out_dir, session.summary())
+    result["cancelled"] = session.cancelled
+    return result
+
+
+def _read_timeseries_rows(path: Path) -> list:
+    rows = []
+    with open(path, newline="") as f:
+        for r in csv.DictReader(f):
+            rows.append({k: float(v) if "." in v or "e" in v else int(v) for k, v in r.items()})
+    return rows
+
+
+def _live_subprocess(req: RunRequest, live: LiveRun):
+    # The CLI only writes its outputs at the end, so rows arrive in one batch
+    bin_path = resolve_path(os.environ.get("KV_SIM_BIN", str(BIN_DEFAULT)))
+    if not bin_path.exists():
+        raise RuntimeError(f"Binary not found: {bin_path}")
+    trace_path = write_trace_temp(req.trace_content, req.trace_name or "trace.txt") if req.trace_content \
+        else resolve_path(req.trace_path)
+    config_path = write_config_temp(req.config_options) if req.config_options else None
+    try:
+        live.out_dir.parent.mkdir(parents=True, exist_ok=True)
+        cmd = [str(bin_path), "--trace", str(trace_path), "--out", str(live.out_dir)]
+        if config_path:
+            cmd.extend(["--config", str(config_path)])
+        if req.seed is not None:
+            cmd.extend(["--seed", str(req.seed)])
+        if CACHE_DIR is not None:
+            cmd.extend(["--cache-dir", CACHE_DIR])
+        live.proc = subprocess.Popen(cmd, stdout=subprocess.PIPE, stderr=subprocess.PIPE, text=True)
+        if live.cancel_requested:
+            live.proc.terminate()
+        out, err = live.proc.communicate()
+        if live.cancel_requested:
+            raise RuntimeError("cancelled")
+        if live.proc.returncode != 0:
+            raise RuntimeError(err or out or "simulator failed")
+        live.push_rows(_read_timeseries_rows(live.out_dir / "timeseries.csv"))
+        result = run_response(live.run_id, live.out_dir, cached=out.startswith("Cache hit"))
+        result["cancelled"] = False
+        return result
+    finally:
+        for p in (config_path, trace_path if req.trace_content else None):
+            if p and p.exists():
+                try:
+                    p.unlink()
+                except OSError:
+                    pass
+
+
+def _live_worker(req: RunRequest, live: LiveRun):
+    try:
+        result = _live_native(req, live) if USE_NATIVE else _live_subprocess(req, live)
+        live.finish(result=result)
+    except HTTPException as e:
+        live.finish(error=str(e.detail))
+    except Exception as e:  # surfaced to the client as an "error" event
+        live.finish(error=str(e))
+
+
+@app.post("/runs")
+def start_run(req: RunRequest):
+    if not req.trace_content and not req.trace_path:
+        raise HTTPException(status_code=400, detail="Provide trace_content or trace_path")
+    if req.trace_path and not req.trace_content and not resolve_path(req.trace_path).exists():
+        raise HTTPException(status_code=400, detail=f"Trace not found: {req.trace_path}")
+    run_id = uuid.uuid4().hex[:8]
+    out_dir = resolve_path(req.out_dir) if req.out_dir else RUNS_ROOT / run_id
+    live = LiveRun(run_id, out_dir)
+    with LIVE_RUNS_LOCK:
+        if len(LIVE_RUNS) >= MAX_LIVE_RUNS:
+            for stale in [k for k, v in LIVE_RUNS.items() if v.done]:
+                del LIVE_RUNS[stale]
+        LIVE_RUNS[run_id] = live
+    threading.Thread(target=_live_worker, args=(req, live), daemon=True).start()
+    return {
+        "run_id": run_id,
+        "native": USE_NATIVE,
+        "stream_url": f"/runs/{run_id}/stream",
+        "cancel_url": f"/runs/{run_id}/cancel",
+    }
+
+
+def _live_run(run_id: str) -> LiveRun:
+    with LIVE_RUNS_LOCK:
+        live = LIVE_RUNS.get(run_id)
+    if live is None:
+        raise HTTPException(status_code=404, detail=f"No live run {run_id}")
+    return live
+
+
+def _sse(event: str, data: Any) -> str:
+    return f"event: {event}\ndata: {json.dumps(data)}\n\n"
+
+
+@app.get("/runs/{run_id}/stream")
+def stream_run(run_id: str):
+    live = _live_run(run_id)
+
+    def events():
+        sent = 0
+        while True:
+            with live.cond:
+                while sent == len(live.rows) and not live.done:
+                    live.cond.wait(timeout=15.0)
+                    if sent == len(live.rows) and not live.done:
+                        break  # idle: fall through and send a keep-alive comment
+                rows = live.rows[sent:]
+                done = live.done
+            if rows:
+                sent += len(rows)
+                yield _sse("timeseries", {"rows": rows})
+            elif not done:
+                yield ": keep-alive\n\n"
+            if done and sent == len(live.rows):
+                if live.error is not None:
+                    yield _sse("error", {"detail": live.error})
+                else:
+                    yield _sse("done", live.result)
+                with LIVE_RUNS_LOCK:
+                    LIVE_RUNS.pop(run_id, None)
+                return
+
+    return StreamingResponse(events(), media_type="text/event-stream",
+                             headers={"Cache-Control": "no-cache", "X-Accel-Buffering": "no"})
+
+
+@app.post("/runs/{run_id}/cancel")
+def cancel_run(run_id: str):
+    live = _live_run(run_id)
+    live.cancel_requested = True
+    if live.session is not None:
+        live.session.cancel()
+    if live.proc is not None and live.proc.poll() is None:
+        live.proc.terminate()
+    return {"run_id": run_id, "cancel_requested": True}
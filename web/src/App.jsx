@@ -1,4 +1,4 @@
-import { useState, useMemo } from 'react';
+import { useState, useMemo, useRef } from 'react';
 import Papa from 'papaparse';
 import KpiCard from './components/KpiCard.jsx';
 import PlotCard from './components/PlotCard.jsx';
@@ -43,6 +43,9 @@ export default function App() {
   const [runLabel, setRunLabel] = useState('');
   const [error, setError] = useState('');
   const [loading, setLoading] = useState(false);
+  // Live run: rows stream in over server-sent events until "done"
+  const [liveRun, setLiveRun] = useState(null);
+  const streamRef = useRef(null);
 
   // Form for backend run
   const [traceContent, setTraceContent] = useState(`# id arrival_ms prompt_tokens gen_tokens streaming(0/1)
@@ -94,6 +97,8 @@ req3 100 180 320 0`);
   const handleRunSim = async () => {
     setError('');
     setLoading(true);
+    setSummary(null);
+    setTimeseries([]);
     try {
       const body = {
         trace_content: traceContent,
@@ -117,7 +122,7 @@ req3 100 180 320 0`);
           }
         });
       });
-      const resp = await fetch(`${BACKEND_BASE}/run`, {
+      const resp = await fetch(`${BACKEND_BASE}/runs`, {
         method: 'POST',
         headers: { 'Content-Type': 'application/json' },
         body: JSON.stringify(body),
@@ -126,19 +131,55 @@ req3 100 180 320 0`);
         const msg = await resp.text();
         throw new Error(msg || `Backend error ${resp.status}`);
       }
-      const data = await resp.json();
-      setSummary(data.summary);
-      const ts = await parseTimeseriesFromUrl(`${BACKEND_BASE}${data.timeseries_url}`);
-      setTimeseries(ts);
-      setRunLabel(data.run_id);
+      const run = await resp.json();
+      setRunLabel(run.run_id);
+      setLiveRun(run);
+
+      const es = new EventSource(`${BACKEND_BASE}${run.stream_url}`);
+      streamRef.current = es;
+      const close = () => {
+        es.close();
+        streamRef.current = null;
+        setLiveRun(null);
+        setLoading(false);
+      };
+      es.addEventListener('timeseries', (e) => {
+        const { rows } = JSON.parse(e.data);
+        setTimeseries((prev) => prev.concat(rows));
+      });
+      es.addEventListener('done', async (e) => {
+        const data = JSON.parse(e.data);
+        close();
+        setSummary(data.summary);
+        setRunLabel(data.cancelled ? `${data.run_id} (cancelled)` : data.run_id);
+        // Streamed rows are what the run wrote; reload only if the stream missed some
+        if (!data.cancelled) {
+          const ts = await parseTimeseriesFromUrl(`${BACKEND_BASE}${data.timeseries_url}`);
+          setTimeseries(ts);
+        }
+      });
+      es.addEventListener('error', (e) => {
+        // Server "error" events carry data; transport errors do not
+        const detail = e.data ? JSON.parse(e.data).detail : 'Lost connection to the backend.';
+        close();
+        setError(detail);
+      });
     } catch (err) {
       console.error(err);
       setError(err.message || 'Failed to run simulation.');
-    } finally {
       setLoading(false);
     }
   };
 
+  const handleCancel = async () => {
+    if (!liveRun) return;
+    try {
+      await fetch(`${BACKEND_BASE}${liveRun.cancel_url}`, { method: 'POST' });
+    } catch (err) {
+      console.error(err);
+    }
+  };
+
   const derived = useMemo(() => {
     if (!timeseries.length) return { t: [], vram: [], queue: [], tps: [], globalQueue: [], vramPerGpu: [] };
     const t = timeseries.map((r) => r.time_ms);
@@ -191,7 +232,7 @@ req3 100 180 320 0`);
           <div>
             <h1 className="text-2xl font-bold">KV Sim Viewer</h1>
             <p className="text-sm text-slate-400">
-              Enter a trace and config; backend runs C++ and we replot outputs
+              Enter a trace and config; backend runs C++ and plots stream in as it progresses
             </p>
           </div>
         </header>
@@ -274,6 +315,14 @@ req3 100 180 320 0`);
             >
               {loading ? 'Running...' : 'Run simulation'}
             </button>
+            {liveRun && (
+              <button
+                onClick={handleCancel}
+                className="ml-2 px-3 py-2 rounded bg-slate-700 hover:bg-slate-600 text-sm font-semibold"
+              >
+                Cancel
+              </button>
+            )}
           </div>
         </div>
 
@@ -284,7 +333,14 @@ req3 100 180 320 0`);
           </div>
         )}
 
-        {summary && (
+        {liveRun && (
+          <div className="text-sm text-slate-400">
+            Streaming <span className="text-slate-200 font-semibold">{runLabel}</span>: {timeseries.length} samples
+            {timeseries.length > 0 && ` up to ${Math.round(timeseries[timeseries.length - 1].time_ms)} ms`}
+          </div>
+        )}
+
+        {(summary || liveRun) && (
           <>
             <div className="grid grid-cols-1 sm:grid-cols-2 md:grid-cols-4 gap-3">
               {kpis.map(([label, value]) => (
@@ -293,7 +349,7 @@ req3 100 180 320 0`);
             </div>
 
             {/* Per-GPU summary table */}
-            {summary.per_gpu && summary.per_gpu.length > 1 && (
+            {summary && summary.per_gpu && summary.per_gpu.length > 1 && (
               <div className="rounded-lg border border-slate-800 bg-slate-900 p-4">
                 <div className="text-sm font-semibold text-slate-200 mb-2">Per-GPU Breakdown</div>
                 <table className="w-full text-sm">